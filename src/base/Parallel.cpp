@@ -0,0 +1,91 @@
+/******************************************************************************
+ *
+ *    This file is part of openDarkEngine project
+ *    Copyright (C) 2005-2006 openDarkEngine team
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *	$Id$
+ *
+ *****************************************************************************/
+
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Opde {
+
+//------------------------------------
+size_t getWorkerCount() {
+    static const size_t count =
+        std::max<size_t>(1, std::thread::hardware_concurrency());
+
+    return count;
+}
+
+//------------------------------------
+void parallelFor(size_t count, const std::function<void(size_t)> &job,
+                 size_t minParallel) {
+    size_t workers = std::min(getWorkerCount(), count);
+
+    if (count < minParallel || workers < 2) {
+        for (size_t idx = 0; idx < count; ++idx) job(idx);
+
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    // every worker pulls the next unprocessed index until none is left
+    auto worker = [&]() {
+        size_t idx;
+
+        while (!failed && (idx = next++) < count) {
+            try {
+                job(idx);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+
+                if (!error)
+                    error = std::current_exception();
+
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+
+    for (size_t t = 1; t < workers; ++t) threads.emplace_back(worker);
+
+    worker();
+
+    for (auto &thread : threads) thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+} // namespace Opde
@@ -0,0 +1,54 @@
+/******************************************************************************
+ *
+ *    This file is part of openDarkEngine project
+ *    Copyright (C) 2005-2006 openDarkEngine team
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *	$Id$
+ *
+ *****************************************************************************/
+
+#ifndef __PARALLEL_H
+#define __PARALLEL_H
+
+#include "config.h"
+
+#include <cstddef>
+#include <functional>
+
+namespace Opde {
+
+/** Returns the count of worker threads parallel jobs are split to. Equals the
+ * count of the hardware threads (at least 1) */
+size_t getWorkerCount();
+
+/** Calls job(index) for all the indices in [0, count), distributing the calls
+ * over the worker threads. The calling thread takes part in the work and the
+ * call returns after all the jobs finished.
+ * @param count The count of the jobs
+ * @param job The job to run. Has to be safe to call concurrently for
+ * different indices
+ * @param minParallel Job counts lower than this are run serially, as
+ * spawning the threads would cost more than it saves
+ * @note If some of the jobs throw, the remaining jobs are skipped and the
+ * first exception caught is rethrown in the calling thread */
+void parallelFor(size_t count, const std::function<void(size_t)> &job,
+                 size_t minParallel = 2);
+
+} // namespace Opde
+
+#endif
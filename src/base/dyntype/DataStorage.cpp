@@ -29,6 +29,40 @@ using namespace std;
 
 namespace Opde {
 
+/*------------------------------------------------------*/
+/*------------------- DataStorage ----------------------*/
+/*------------------------------------------------------*/
+FieldHandle DataStorage::getFieldHandle(const std::string &field) {
+    const DataFields &fields = getFieldDesc();
+
+    for (size_t idx = 0; idx < fields.size(); ++idx) {
+        if (fields[idx].name == field)
+            return FieldHandle(static_cast<int>(idx));
+    }
+
+    return FieldHandle();
+}
+
+//------------------------------------
+bool DataStorage::getField(int objID, FieldHandle field, Variant &target) {
+    const DataFields &fields = getFieldDesc();
+
+    if (!field.isValid() || static_cast<size_t>(field.index()) >= fields.size())
+        return false;
+
+    return getField(objID, fields[field.index()].name, target);
+}
+
+//------------------------------------
+bool DataStorage::setField(int objID, FieldHandle field, const Variant &value) {
+    const DataFields &fields = getFieldDesc();
+
+    if (!field.isValid() || static_cast<size_t>(field.index()) >= fields.size())
+        return false;
+
+    return setField(objID, fields[field.index()].name, value);
+}
+
 /*------------------------------------------------------*/
 /*------------------- Enumeration ----------------------*/
 /*------------------------------------------------------*/
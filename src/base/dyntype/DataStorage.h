@@ -30,6 +30,8 @@
 #include "File.h"
 #include "Iterator.h"
 
+#include <typeinfo>
+
 namespace Opde {
 
 /** Type aware variant based enumeration definition. Used for enumeration and
@@ -116,6 +118,49 @@ struct DataFieldDesc {
 
 typedef std::vector<DataFieldDesc> DataFields;
 
+/** Precompiled field reference - the index of the field in the DataFields of a
+ * storage. Resolved once by DataStorage::getFieldHandle, it spares the field
+ * name lookup on every access.
+ * @note Only valid with the storage (or one of the same type) it was resolved
+ * by */
+class FieldHandle {
+public:
+    /// Constructs an invalid handle
+    FieldHandle() : mIndex(-1){};
+
+    explicit FieldHandle(int index) : mIndex(index){};
+
+    /// @return true if the handle refers to a field
+    bool isValid() const { return mIndex >= 0; };
+
+    /// @return the index of the field in the DataFields
+    int index() const { return mIndex; };
+
+private:
+    int mIndex;
+};
+
+/** Non owning reference to a callable taking an object id, as used by
+ * DataStorage::forEachStored. Constructed from any function or lambda without
+ * allocation.
+ * @note Must not outlive the callable it refers to */
+class ObjectVisitor {
+public:
+    template <typename F>
+    ObjectVisitor(const F &fn) : mFunc(&fn), mCall(&callFunc<F>){};
+
+    /// Calls the referred callable with the object id
+    void operator()(int objID) const { mCall(mFunc, objID); };
+
+private:
+    template <typename F> static void callFunc(const void *fn, int objID) {
+        (*static_cast<const F *>(fn))(objID);
+    }
+
+    const void *mFunc;
+    void (*mCall)(const void *, int);
+};
+
 /** @brief Storage for data (Interface). This class is used as a backend for
  * either property or link storage, and provides data these classes. This
  * storage can be overriden to suit better for particular data handling to be
@@ -195,6 +240,22 @@ public:
     virtual bool setField(int objID, const std::string &field,
                           const Variant &value) = 0;
 
+    /** Resolves the field name to a handle usable with the handle based
+     * getField and setField
+     * @param field The field name
+     * @return The handle, invalid if there is no such field */
+    virtual FieldHandle getFieldHandle(const std::string &field);
+
+    /** Field value getter using a precompiled field handle. The default
+     * forwards to the named version
+     * @see getField(int, const std::string &, Variant &) */
+    virtual bool getField(int objID, FieldHandle field, Variant &target);
+
+    /** Field value setter using a precompiled field handle. The default
+     * forwards to the named version
+     * @see setField(int, const std::string &, const Variant &) */
+    virtual bool setField(int objID, FieldHandle field, const Variant &value);
+
     /** Serialization core routine
      * This routine is used to serialize the data for given object ID into a
      *File handle. Normally, this routine should write data for the stored data
@@ -228,6 +289,25 @@ public:
      */
     virtual bool readFromFile(FilePtr &file, int objID, bool sizeStored) = 0;
 
+    /** Fixed record size getter. Storages that store the same amount of data
+     * for every object report it here, and support readFromSpan
+     * @return The stored size of one object's data in bytes, or 0 if it varies
+     */
+    virtual size_t getStoredSize(void) { return 0; };
+
+    /** Bulk deserialization routine. Decodes one object's data of
+     * getStoredSize bytes (without the size prefix) from a span of the whole
+     * chunk, so the records can be decoded in one pass without per field file
+     * reads. Only valid for storages with nonzero getStoredSize
+     * @param span The span, positioned at the object's data. Advanced past it
+     * even if nothing was loaded
+     * @param objID The id of the object data to read
+     * @return true if loaded, false if the object already had data
+     * @see readFromFile */
+    virtual bool readFromSpan(FileSpan &span, int objID) {
+        OPDE_EXCEPT("Invalid call - storage has no fixed record size");
+    };
+
     /** Called to clear all data */
     virtual void clear() = 0;
 
@@ -239,6 +319,17 @@ public:
      */
     virtual IntIteratorPtr getAllStoredObjects() = 0;
 
+    /** Calls the visitor for every stored object ID. Unlike
+     * getAllStoredObjects, this needs no allocation and no virtual call per
+     * object. The default implementation walks getAllStoredObjects
+     * @note The storage must not be modified from the visitor */
+    virtual void forEachStored(const ObjectVisitor &visitor) {
+        IntIteratorPtr it = getAllStoredObjects();
+
+        while (!it->end())
+            visitor(it->next());
+    };
+
     /** Optional handler for object ID range re-sets (f.e. when growing the
      * concretes)
      */
@@ -254,6 +345,18 @@ public:
     /** Data size getter
      * @return Data size, if available. 0 otherwise */
     virtual size_t getDataSize(void) { return 0; };
+
+    /** Direct access to the stored value of the given object, bypassing the
+     * Variant based field access. The pointer stays valid until the next
+     * create, destroy or clear on this storage
+     * @return Pointer to the value of type getDataType, NULL if the object
+     * has no value or the storage does not support direct access */
+    virtual const void *getDataPtr(int objID) { return NULL; };
+
+    /** Type of the values returned by getDataPtr
+     * @return typeid of the stored value, typeid(void) if the storage does not
+     * support direct access */
+    virtual const std::type_info &getDataType(void) { return typeid(void); };
 };
 
 /// Shared pointer to data storage
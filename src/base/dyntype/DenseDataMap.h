@@ -0,0 +1,196 @@
+/******************************************************************************
+ *
+ *    This file is part of openDarkEngine project
+ *    Copyright (C) 2005-2006 openDarkEngine team
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *		$Id$
+ *
+ *****************************************************************************/
+
+#ifndef __DENSEDATAMAP_H
+#define __DENSEDATAMAP_H
+
+#include "config.h"
+
+#include "integers.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace Opde {
+
+/** Object ID indexed data container - a sparse set. The values are packed
+ * densely in one array together with their ids, and an index array covering
+ * the object ID range maps the ids to the packed positions. Lookups are a
+ * single array access, iteration walks contiguous memory.
+ *
+ * Implements the subset of the std::map<int, T> interface the data storages
+ * use, so it can be given to them as the DataMap template parameter.
+ * @note The iteration order is the insertion order (erase moves the last
+ * element to the freed place), not the id order
+ * @note Unlike with std::map, insert and erase invalidate the iterators */
+template <typename T> class DenseDataMap {
+public:
+    typedef int key_type;
+    typedef T mapped_type;
+    typedef std::pair<int, T> value_type;
+
+    typedef std::vector<value_type> Values;
+    typedef typename Values::iterator iterator;
+    typedef typename Values::const_iterator const_iterator;
+
+    DenseDataMap() : mMinID(0){};
+
+    iterator begin() { return mValues.begin(); };
+    iterator end() { return mValues.end(); };
+    const_iterator begin() const { return mValues.begin(); };
+    const_iterator end() const { return mValues.end(); };
+
+    size_t size() const { return mValues.size(); };
+    bool empty() const { return mValues.empty(); };
+
+    iterator find(int id) {
+        size_t pos = position(id);
+        return pos ? mValues.begin() + (pos - 1) : mValues.end();
+    }
+
+    const_iterator find(int id) const {
+        size_t pos = position(id);
+        return pos ? mValues.begin() + (pos - 1) : mValues.end();
+    }
+
+    /** Inserts the value if the id is not present yet
+     * @return the position of the id's value, and true if inserted */
+    std::pair<iterator, bool> insert(const value_type &val) {
+        size_t pos = position(val.first);
+
+        if (pos)
+            return std::make_pair(mValues.begin() + (pos - 1), false);
+
+        grow(val.first, val.first + 1);
+
+        mValues.push_back(val);
+        mIndex[val.first - mMinID] = static_cast<uint32_t>(mValues.size());
+
+        return std::make_pair(mValues.end() - 1, true);
+    }
+
+    /// Removes the value at the given position
+    void erase(iterator it) {
+        size_t pos = it - mValues.begin();
+
+        mIndex[it->first - mMinID] = 0;
+
+        // the last value takes the freed place
+        if (pos + 1 != mValues.size()) {
+            *it = mValues.back();
+            mIndex[it->first - mMinID] = static_cast<uint32_t>(pos + 1);
+        }
+
+        mValues.pop_back();
+    }
+
+    /// Removes the value of the given id. @return count of removed values
+    size_t erase(int id) {
+        iterator it = find(id);
+
+        if (it == end())
+            return 0;
+
+        erase(it);
+        return 1;
+    }
+
+    /// Removes all the values. The id range stays allocated
+    void clear() {
+        mValues.clear();
+        mIndex.assign(mIndex.size(), 0);
+    }
+
+    /** Extends the covered id range to include [minID, maxID). The range is
+     * never shrunk. Called with the whole object range by the storages, and
+     * with single ids by insert (then extending at least twice the size) */
+    void grow(int minID, int maxID) {
+        if (maxID <= minID)
+            return;
+
+        int curMax = mMinID + static_cast<int>(mIndex.size());
+
+        if (mIndex.empty()) {
+            mMinID = minID;
+            mIndex.resize(maxID - minID, 0);
+            return;
+        }
+
+        if (minID >= mMinID && maxID <= curMax)
+            return;
+
+        int span = curMax - mMinID;
+
+        int newMin = mMinID;
+        int newMax = curMax;
+
+        if (minID < mMinID)
+            newMin = std::min(minID, mMinID - span);
+
+        if (maxID > curMax)
+            newMax = std::max(maxID, curMax + span);
+
+        std::vector<uint32_t> index(newMax - newMin, 0);
+
+        std::copy(mIndex.begin(), mIndex.end(),
+                  index.begin() + (mMinID - newMin));
+
+        mIndex.swap(index);
+        mMinID = newMin;
+    }
+
+protected:
+    /// Packed position + 1 of the id's value, 0 if not present
+    size_t position(int id) const {
+        // unsigned compare covers the ids under the range as well
+        size_t idx = static_cast<size_t>(static_cast<int64_t>(id) - mMinID);
+
+        return (idx < mIndex.size()) ? mIndex[idx] : 0;
+    }
+
+    /// The values with their ids, packed
+    Values mValues;
+
+    /// Packed position + 1 per id, starting with mMinID
+    std::vector<uint32_t> mIndex;
+
+    /// The first id covered by mIndex
+    int mMinID;
+};
+
+/// Prepares the data map for the object id range. Nothing to do for std::map
+template <typename T>
+inline void growDataMap(std::map<int, T> &map, int minID, int maxID) {}
+
+/// Prepares the data map for the object id range
+template <typename T>
+inline void growDataMap(DenseDataMap<T> &map, int minID, int maxID) {
+    map.grow(minID, maxID);
+}
+
+} // namespace Opde
+
+#endif
@@ -23,6 +23,8 @@
 
 #include "Serializer.h"
 
+#include <cstring>
+
 namespace Opde {
 
 template <>
@@ -41,6 +43,14 @@ void TypeSerializer<bool>::deserialize(FilePtr &src, void *valuePtr) {
     *static_cast<bool *>(valuePtr) = conv ? true : false;
 };
 
+template <>
+void TypeSerializer<bool>::deserialize(FileSpan &src, void *valuePtr) {
+    uint32_t conv;
+    src.readElem(&conv, sizeof(uint32_t));
+
+    *static_cast<bool *>(valuePtr) = conv ? true : false;
+};
+
 template <> size_t TypeSerializer<bool>::getStoredSize(const void *valuePtr) {
     return sizeof(uint32_t);
 }
@@ -73,6 +83,19 @@ void TypeSerializer<Vector3>::deserialize(FilePtr &src, void *valuePtr) {
     result->z = z;
 };
 
+template <>
+void TypeSerializer<Vector3>::deserialize(FileSpan &src, void *valuePtr) {
+    float xyz[3];
+
+    src.readElem(xyz, sizeof(float), 3);
+
+    Vector3 *result = static_cast<Vector3 *>(valuePtr);
+
+    result->x = xyz[0];
+    result->y = xyz[1];
+    result->z = xyz[2];
+};
+
 template <>
 size_t TypeSerializer<Vector3>::getStoredSize(const void *valuePtr) {
     return sizeof(float) * 3;
@@ -100,15 +123,9 @@ void TypeSerializer<Ogre::Quaternion>::serialize(FilePtr &dest,
     dest->writeElem(&b, sizeof(int16_t));
 };
 
-template <>
-void TypeSerializer<Ogre::Quaternion>::deserialize(FilePtr &src,
-                                                   void *valuePtr) {
-    int16_t h, p, b;
-
-    src->readElem(&h, sizeof(int16_t));
-    src->readElem(&p, sizeof(int16_t));
-    src->readElem(&b, sizeof(int16_t));
-
+/// Converts the on-disk HPB angles to the quaternion
+static void HPBToQuaternion(int16_t h, int16_t p, int16_t b,
+                            Ogre::Quaternion *q) {
     Ogre::Real x, y, z;
 
     /* Order of HPB application is crucial. It was detected that Dark orders HPB
@@ -126,9 +143,30 @@ void TypeSerializer<Ogre::Quaternion>::deserialize(FilePtr &src,
     // Still not there, but close
     m.FromEulerAnglesZYX(Ogre::Radian(z), Ogre::Radian(y), Ogre::Radian(x));
 
-    Ogre::Quaternion *q = static_cast<Ogre::Quaternion *>(valuePtr);
-
     q->FromRotationMatrix(m);
+}
+
+template <>
+void TypeSerializer<Ogre::Quaternion>::deserialize(FilePtr &src,
+                                                   void *valuePtr) {
+    int16_t h, p, b;
+
+    src->readElem(&h, sizeof(int16_t));
+    src->readElem(&p, sizeof(int16_t));
+    src->readElem(&b, sizeof(int16_t));
+
+    HPBToQuaternion(h, p, b, static_cast<Ogre::Quaternion *>(valuePtr));
+};
+
+template <>
+void TypeSerializer<Ogre::Quaternion>::deserialize(FileSpan &src,
+                                                   void *valuePtr) {
+    int16_t hpb[3];
+
+    src.readElem(hpb, sizeof(int16_t), 3);
+
+    HPBToQuaternion(hpb[0], hpb[1], hpb[2],
+                    static_cast<Ogre::Quaternion *>(valuePtr));
 };
 
 template <>
@@ -167,8 +205,22 @@ void TypeSerializer<std::string>::deserialize(FilePtr &src, void *valuePtr) {
     *static_cast<std::string *>(valuePtr) = sobj;
 };
 
+template <>
+void TypeSerializer<std::string>::deserialize(FileSpan &src, void *valuePtr) {
+    uint32_t size;
+
+    src.readElem(&size, sizeof(uint32_t));
+
+    const char *str = src.skip(size);
+
+    // the stored string may be zero terminated before its size
+    *static_cast<std::string *>(valuePtr) = std::string(str, strnlen(str, size));
+};
+
 template <>
 size_t TypeSerializer<std::string>::getStoredSize(const void *valuePtr) {
     return static_cast<const std::string *>(valuePtr)->size();
 }
+
+template <> bool TypeSerializer<std::string>::isFixedSize() { return false; }
 } // namespace Opde
@@ -32,6 +32,7 @@
 
 #include "File.h"
 #include "NonCopyable.h"
+#include "StringPool.h"
 #include "Vector3.h"
 
 namespace Opde {
@@ -49,8 +50,14 @@ public:
     /// deserializes the data from the specified fileptr
     virtual void deserialize(FilePtr &src, void *valuePtr) = 0;
 
+    /// deserializes the data from the specified span of a file
+    virtual void deserialize(FileSpan &src, void *valuePtr) = 0;
+
     /// Returns the stored size of the type
     virtual size_t getStoredSize(const void *valuePtr) = 0;
+
+    /// Returns true if the stored size does not depend on the value
+    virtual bool isFixedSize() { return true; };
 };
 
 /// Default template implementation of the serializer
@@ -64,7 +71,13 @@ public:
         src->readElem(valuePtr, sizeof(T));
     };
 
+    virtual void deserialize(FileSpan &src, void *valuePtr) {
+        src.readElem(valuePtr, sizeof(T));
+    };
+
     virtual size_t getStoredSize(const void *valuePtr) { return sizeof(T); };
+
+    virtual bool isFixedSize() { return true; };
 };
 
 /// Fixed size string serializer - serializes first N characters of given string
@@ -106,10 +119,87 @@ public:
         static_cast<std::string *>(valuePtr)->assign(copyStr);
     }
 
+    /// deserializes the data from the specified span of a file
+    virtual void deserialize(FileSpan &src, void *valuePtr) {
+        char copyStr[LenT + 1];
+        src.read(copyStr, LenT);
+        copyStr[LenT] = '\0';
+        static_cast<std::string *>(valuePtr)->assign(copyStr);
+    }
+
     /// Returns the stored size of the type
     virtual size_t getStoredSize(const void *valuePtr) { return LenT; }
 };
 
+/// Serializer of pooled strings. Stores them the way BaseSerT stores strings
+template <typename BaseSerT> class InternedStringSerializer : public Serializer {
+public:
+    virtual void serialize(FilePtr &dest, const void *valuePtr) {
+        mBase.serialize(dest, &toString(valuePtr));
+    };
+
+    virtual void deserialize(FilePtr &src, void *valuePtr) {
+        std::string str;
+        mBase.deserialize(src, &str);
+        *static_cast<InternedString *>(valuePtr) = InternedString(str);
+    };
+
+    virtual void deserialize(FileSpan &src, void *valuePtr) {
+        std::string str;
+        mBase.deserialize(src, &str);
+        *static_cast<InternedString *>(valuePtr) = InternedString(str);
+    };
+
+    virtual size_t getStoredSize(const void *valuePtr) {
+        return mBase.getStoredSize(valuePtr ? &toString(valuePtr) : NULL);
+    };
+
+    virtual bool isFixedSize() { return mBase.isFixedSize(); };
+
+protected:
+    static const std::string &toString(const void *valuePtr) {
+        return static_cast<const InternedString *>(valuePtr)->str();
+    }
+
+    BaseSerT mBase;
+};
+
+/** Compile time info about a serializer, used by the struct field tables.
+ * storedSize is the stored size of every value, 0 if it varies */
+template <typename SerT> struct SerializerTraits {
+    static const size_t storedSize = 0;
+};
+
+template <typename T> struct SerializerTraits<TypeSerializer<T>> {
+    static const size_t storedSize = sizeof(T);
+};
+
+template <size_t LenT>
+struct SerializerTraits<FixedStringSerializer<LenT>> {
+    static const size_t storedSize = LenT;
+};
+
+template <typename BaseSerT>
+struct SerializerTraits<InternedStringSerializer<BaseSerT>> {
+    static const size_t storedSize = SerializerTraits<BaseSerT>::storedSize;
+};
+
+template <> struct SerializerTraits<TypeSerializer<bool>> {
+    static const size_t storedSize = sizeof(uint32_t);
+};
+
+template <> struct SerializerTraits<TypeSerializer<Vector3>> {
+    static const size_t storedSize = sizeof(float) * 3;
+};
+
+template <> struct SerializerTraits<TypeSerializer<Ogre::Quaternion>> {
+    static const size_t storedSize = sizeof(int16_t) * 3;
+};
+
+template <> struct SerializerTraits<TypeSerializer<std::string>> {
+    static const size_t storedSize = 0;
+};
+
 // specializations for various special types
 
 /// Bool specialization of the TypeSerializer::serialize
@@ -118,6 +208,9 @@ void TypeSerializer<bool>::serialize(FilePtr &dest, const void *valuePtr);
 /// Bool specialization of the TypeSerializer::deserialize
 template <>
 void TypeSerializer<bool>::deserialize(FilePtr &src, void *valuePtr);
+/// Bool specialization of the TypeSerializer::deserialize from span
+template <>
+void TypeSerializer<bool>::deserialize(FileSpan &src, void *valuePtr);
 /// Bool stored size getter
 template <> size_t TypeSerializer<bool>::getStoredSize(const void *valuePtr);
 
@@ -127,6 +220,9 @@ void TypeSerializer<Vector3>::serialize(FilePtr &dest, const void *valuePtr);
 /// Vector3 specialization of the TypeSerializer::deserialize
 template <>
 void TypeSerializer<Vector3>::deserialize(FilePtr &src, void *valuePtr);
+/// Vector3 specialization of the TypeSerializer::deserialize from span
+template <>
+void TypeSerializer<Vector3>::deserialize(FileSpan &src, void *valuePtr);
 /// Vector3 stored size getter
 template <> size_t TypeSerializer<Vector3>::getStoredSize(const void *valuePtr);
 
@@ -139,6 +235,10 @@ void TypeSerializer<Ogre::Quaternion>::serialize(FilePtr &dest,
 template <>
 void TypeSerializer<Ogre::Quaternion>::deserialize(FilePtr &src,
                                                    void *valuePtr);
+/// Quaternion specialization of the TypeSerializer::deserialize from span
+template <>
+void TypeSerializer<Ogre::Quaternion>::deserialize(FileSpan &src,
+                                                   void *valuePtr);
 /// Quaternion stored size getter
 template <>
 size_t TypeSerializer<Ogre::Quaternion>::getStoredSize(const void *valuePtr);
@@ -150,9 +250,14 @@ void TypeSerializer<std::string>::serialize(FilePtr &dest,
 /// Variable length string specialization of the Serializer::deserialize
 template <>
 void TypeSerializer<std::string>::deserialize(FilePtr &src, void *valuePtr);
+/// Variable length string specialization of the deserialize from span
+template <>
+void TypeSerializer<std::string>::deserialize(FileSpan &src, void *valuePtr);
 /// Variable length string stored size getter
 template <>
 size_t TypeSerializer<std::string>::getStoredSize(const void *valuePtr);
+/// Variable length string is not fixed size
+template <> bool TypeSerializer<std::string>::isFixedSize();
 
 } // namespace Opde
 
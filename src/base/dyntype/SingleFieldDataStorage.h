@@ -27,6 +27,7 @@
 #include "config.h"
 
 #include "DataStorage.h"
+#include "DenseDataMap.h"
 
 #include "Variant.h"
 #include "File.h"
@@ -36,8 +37,11 @@
 namespace Opde {
 
 /** Common ancestor template for all the single value data storages (with fixed
- * length data) */
-template <typename T, typename SerT = TypeSerializer<T>>
+ * length data)
+ * @param DataMapT The container of the values
+ * @see StructDataStorage */
+template <typename T, typename SerT = TypeSerializer<T>,
+          typename DataMapT = std::map<int, T>>
 class SingleFieldDataStorage : public DataStorage {
 public:
     explicit SingleFieldDataStorage(Enumeration *enm) : mFieldDesc(), mSerializer() {
@@ -51,6 +55,11 @@ public:
 
     virtual ~SingleFieldDataStorage() { }
 
+    // the handle based accessors forward to the named ones, which only have
+    // the single field to look at
+    using DataStorage::getField;
+    using DataStorage::setField;
+
     /** @see DataStorage::create */
     virtual bool create(int objID) {
         // call _create to handle the creation, with the default value
@@ -173,17 +182,48 @@ public:
         return false;
     }
 
+    /** @see DataStorage::getStoredSize */
+    virtual size_t getStoredSize(void) {
+        return mSerializer.isFixedSize() ? mSerializer.getStoredSize(NULL) : 0;
+    }
+
+    /** @see DataStorage::readFromSpan */
+    virtual bool readFromSpan(FileSpan &span, int objID) {
+        if (mDataMap.find(objID) != mDataMap.end()) {
+            // skip the data...
+            span.skip(getStoredSize());
+            return false;
+        }
+
+        T dta;
+
+        mSerializer.deserialize(span, &dta);
+
+        return _create(objID, dta);
+    }
+
     /** @see DataStorage::clear */
     virtual void clear() { mDataMap.clear(); }
 
     /** @see DataStorage::isEmpty */
     virtual bool isEmpty() { return mDataMap.empty(); }
 
+    /** @see DataStorage::grow */
+    virtual void grow(int minID, int maxID) {
+        growDataMap(mDataMap, minID, maxID);
+    }
+
     /** @see DataStorage::getAllStoredObjects */
     virtual IntIteratorPtr getAllStoredObjects() {
         return IntIteratorPtr(new DataMapKeyIterator(mDataMap));
     }
 
+    /** @see DataStorage::forEachStored */
+    virtual void forEachStored(const ObjectVisitor &visitor) {
+        for (const auto &val : mDataMap)
+            visitor(val.first);
+    }
+
     /** Core Data creation routine */
     virtual bool _create(int objID, const T &val) {
         std::pair<typename DataMap::iterator, bool> res =
@@ -200,6 +240,19 @@ public:
     /** @see DataStorage::getDataSize */
     virtual size_t getDataSize(void) { return sizeof(T); }
 
+    /** @see DataStorage::getDataPtr */
+    virtual const void *getDataPtr(int objID) {
+        typename DataMap::const_iterator it = mDataMap.find(objID);
+
+        if (it != mDataMap.end())
+            return &it->second;
+
+        return NULL;
+    }
+
+    /** @see DataStorage::getDataType */
+    virtual const std::type_info &getDataType(void) { return typeid(T); }
+
 protected:
     explicit SingleFieldDataStorage(const DataFieldDesc &fieldDesc)
         : mFieldDesc(1, fieldDesc), mSerializer()
@@ -210,7 +263,7 @@ protected:
     virtual T fromVariant(const Variant &v) const { return v.as<T>(); }
 
     /// Data map
-    typedef typename std::map<int, T> DataMap;
+    typedef DataMapT DataMap;
 
     /// Holder of data values
     DataMap mDataMap;
@@ -242,11 +295,34 @@ typedef SingleFieldDataStorage<uint32_t> UIntDataStorage;
 /// Vector3 data storage
 typedef SingleFieldDataStorage<Vector3> Vector3DataStorage;
 
-/// Variable length string data storage
-class StringDataStorage : public SingleFieldDataStorage<std::string> {
+// Dense variants, for the properties most objects have:
+
+/// Boolean (4 byte) dense data storage
+typedef SingleFieldDataStorage<bool, TypeSerializer<bool>, DenseDataMap<bool>>
+    DenseBoolDataStorage;
+
+/// Float (4 byte) dense data storage
+typedef SingleFieldDataStorage<float, TypeSerializer<float>,
+                               DenseDataMap<float>>
+    DenseFloatDataStorage;
+
+/// unsigned int (4 byte) dense data storage
+typedef SingleFieldDataStorage<uint32_t, TypeSerializer<uint32_t>,
+                               DenseDataMap<uint32_t>>
+    DenseUIntDataStorage;
+
+/// Vector3 dense data storage
+typedef SingleFieldDataStorage<Vector3, TypeSerializer<Vector3>,
+                               DenseDataMap<Vector3>>
+    DenseVector3DataStorage;
+
+/// Variable length string data storage. The strings are pooled
+class StringDataStorage
+    : public SingleFieldDataStorage<
+          InternedString,
+          InternedStringSerializer<TypeSerializer<std::string>>> {
 public:
-    StringDataStorage(Enumeration *enm = NULL)
-        : SingleFieldDataStorage<std::string>(enm) {
+    StringDataStorage(Enumeration *enm = NULL) : SingleFieldDataStorage(enm) {
         mFieldDesc[0].size = -1; // override needed
     }
 
@@ -254,19 +330,30 @@ public:
     virtual size_t getDataSize(void) {
         OPDE_EXCEPT("Invalid call - string length is variable");
     }
+
+protected:
+    virtual InternedString fromVariant(const Variant &v) const {
+        return InternedString(v.toString());
+    }
 };
 
-/// Fixed size string data storage template.
+/// Fixed size string data storage template. The strings are pooled
 template <int Len>
 class FixedStringDataStorage
-    : public SingleFieldDataStorage<std::string, FixedStringSerializer<Len>> {
-    using Parent =
-        SingleFieldDataStorage<std::string, FixedStringSerializer<Len>>;
+    : public SingleFieldDataStorage<
+          InternedString, InternedStringSerializer<FixedStringSerializer<Len>>> {
+    using Parent = SingleFieldDataStorage<
+        InternedString, InternedStringSerializer<FixedStringSerializer<Len>>>;
 
 public:
     FixedStringDataStorage(Enumeration *enm = NULL)
         : Parent(DataFieldDesc{"", "", Len,
                                VariantTypeTraits<std::string>::type}) {}
+
+protected:
+    virtual InternedString fromVariant(const Variant &v) const {
+        return InternedString(v.toString());
+    }
 };
 
 } // namespace Opde
@@ -0,0 +1,89 @@
+/******************************************************************************
+ *
+ *    This file is part of openDarkEngine project
+ *    Copyright (C) 2005-2006 openDarkEngine team
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *		$Id$
+ *
+ *****************************************************************************/
+
+#include "StringPool.h"
+
+namespace Opde {
+
+/*----------------------------------------------------*/
+/*-------------------- StringPool --------------------*/
+/*----------------------------------------------------*/
+StringPool::ID StringPool::intern(const std::string &str) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    std::pair<StringMap::iterator, bool> res =
+        mStrings.insert(std::make_pair(str, 0));
+
+    ++res.first->second;
+
+    return &*res.first;
+}
+
+//------------------------------------
+void StringPool::addRef(ID id) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // the entry is ours, only the count is modified
+    ++const_cast<StringMap::value_type *>(id)->second;
+}
+
+//------------------------------------
+void StringPool::release(ID id) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (--const_cast<StringMap::value_type *>(id)->second == 0)
+        mStrings.erase(mStrings.find(id->first));
+}
+
+//------------------------------------
+StringPool::ID StringPool::find(const std::string &str) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    StringMap::const_iterator it = mStrings.find(str);
+
+    return (it != mStrings.end()) ? &*it : NULL;
+}
+
+//------------------------------------
+size_t StringPool::size() {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return mStrings.size();
+}
+
+//------------------------------------
+StringPool &StringPool::getShared() {
+    // never destroyed, so the strings held by static objects can still be
+    // released on exit
+    static StringPool *pool = new StringPool();
+
+    return *pool;
+}
+
+/*----------------------------------------------------*/
+/*------------------ InternedString ------------------*/
+/*----------------------------------------------------*/
+const std::string InternedString::EMPTY;
+
+} // namespace Opde
@@ -0,0 +1,136 @@
+/******************************************************************************
+ *
+ *    This file is part of openDarkEngine project
+ *    Copyright (C) 2005-2006 openDarkEngine team
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ *		$Id$
+ *
+ *****************************************************************************/
+
+#ifndef __STRINGPOOL_H
+#define __STRINGPOOL_H
+
+#include "config.h"
+
+#include "NonCopyable.h"
+#include "Variant.h"
+#include "integers.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Opde {
+
+/** Reference counted pool of unique strings. Equal strings interned into the
+ * pool share one copy, identified by the address of its pool entry - the ID,
+ * which stays valid as long as the string is referenced. Thread safe, as the string storages of
+ * different properties are loaded concurrently.
+ * @see InternedString */
+class StringPool : public NonCopyable {
+protected:
+    /// The pooled strings with their reference counts
+    typedef std::unordered_map<std::string, uint32_t> StringMap;
+
+public:
+    /// Interned string identifier. Equal strings have equal IDs
+    typedef const StringMap::value_type *ID;
+
+    StringPool(){};
+
+    /** Interns the string, adding a reference to it
+     * @return The ID of the pooled copy */
+    ID intern(const std::string &str);
+
+    /// Adds a reference to an interned string
+    void addRef(ID id);
+
+    /// Releases a reference. The string is dropped with the last one
+    void release(ID id);
+
+    /** Looks up the string without interning it
+     * @return The ID of the string, NULL if not in the pool */
+    ID find(const std::string &str);
+
+    /// Count of the distinct strings in the pool
+    size_t size();
+
+    /// The string of an ID. Needs no locking
+    static const std::string &str(ID id) { return id->first; };
+
+    /// The pool shared by the string data storages
+    static StringPool &getShared();
+
+protected:
+    StringMap mStrings;
+
+    std::mutex mMutex;
+};
+
+/** A string value held in a StringPool. Copies share the pooled string, and
+ * compare by the ID. The empty string is not pooled (NULL ID). */
+class InternedString {
+public:
+    InternedString() : mID(NULL){};
+
+    InternedString(const std::string &str)
+        : mID(str.empty() ? NULL : StringPool::getShared().intern(str)){};
+
+    InternedString(const InternedString &b) : mID(b.mID) {
+        if (mID)
+            StringPool::getShared().addRef(mID);
+    };
+
+    /// noexcept, so the containers move the values on reallocation instead
+    /// of copying (each copy takes the pool lock)
+    InternedString(InternedString &&b) noexcept : mID(b.mID) { b.mID = NULL; };
+
+    ~InternedString() {
+        if (mID)
+            StringPool::getShared().release(mID);
+    };
+
+    InternedString &operator=(InternedString b) noexcept {
+        std::swap(mID, b.mID);
+        return *this;
+    };
+
+    /// The string value
+    const std::string &str() const { return mID ? StringPool::str(mID) : EMPTY; };
+
+    operator const std::string &() const { return str(); };
+
+    /// The pool ID of the string, NULL for the empty string
+    StringPool::ID id() const { return mID; };
+
+    bool operator==(const InternedString &b) const { return mID == b.mID; };
+    bool operator!=(const InternedString &b) const { return mID != b.mID; };
+
+protected:
+    static const std::string EMPTY;
+
+    StringPool::ID mID;
+};
+
+template <> struct VariantTypeTraits<InternedString> {
+    static const Variant::Type type = Variant::DV_STRING;
+};
+
+} // namespace Opde
+
+#endif
@@ -24,11 +24,10 @@
 #ifndef __STRUCTDATASTORAGE_H
 #define __STRUCTDATASTORAGE_H
 
-#include <unordered_map>
-
 #include "config.h"
 
 #include "DataStorage.h"
+#include "DenseDataMap.h"
 
 #include "Variant.h"
 #include "File.h"
@@ -37,78 +36,163 @@
 
 namespace Opde {
 
-/** Common ancestor template for all the struct based data storages. Template
- * parameter is the struct name. To use this, one must expose all the fields of
- * the struct using the field method (which registers the field in all internal
- * structures)
+/** Compile time description of one field of a struct stored in a
+ * StructDataStorage. Use the OPDE_STRUCT_FIELD macro to declare one.
+ * @param T The struct type
+ * @param FT The type of the field
+ * @param Member The member pointer of the field
+ * @param SerT The serializer of the field. Called non-virtually
  */
-template <typename T>
-class StructDataStorage : public DataStorage {
-protected:
-    // forward decl
-    struct TypeHelperBase;
-
-    typedef shared_ptr<TypeHelperBase> TypeHelperBasePtr;
-
-    /** Field setter member pointer - called when setting a value on certain
-     * field
-     * @param field The field name
-     * @param data The struct instance to set value for
-     * @param value the new desired value
-     * @return true if setting was successful, false otherwise
-     */
-
-    typedef bool (StructDataStorage::*FieldSetter)(
-        const TypeHelperBasePtr &helper, T &data, const Variant &value);
-    /** Field getter member pointer - called when setting a value on certain
-     * field
-     * @param field The field name
-     * @param data The struct instance to set value for
-     * @param value the target Variant instance ref to fill with value
-     * @return true if getting was successful, false otherwise
-     */
-    typedef bool (StructDataStorage::*FieldGetter)(
-        const TypeHelperBasePtr &helper, const T &data, Variant &value);
-
-    /// Type helper (for easy struct field manipulation)
-    class TypeHelperBase : public NonCopyable {
-    public:
-        TypeHelperBase(FieldGetter _getter, FieldSetter _setter)
-            : mGetter(_getter), mSetter(_setter) {}
-
-        virtual ~TypeHelperBase() {}
-
-        /// sets the struct's field with the given value
-        virtual void toField(T &data, const Variant &val) = 0;
-
-        /// sets the variant with the value from the struct's field
-        virtual void fromField(const T &data, Variant &val) = 0;
-
-        /// serializer getter
-        virtual Serializer *getSerializer() = 0;
-
-        /// getter access method
-        FieldGetter getter() { return mGetter; };
-
-        /// setter access method
-        FieldSetter setter() { return mSetter; };
-
-        /// field of given struct mem. pointer getter
-        virtual void *getFieldPtr(T &data) = 0;
-
-        /// field of given struct const mem. pointer getter
-        virtual const void *getFieldPtr(const T &data) const = 0;
-
-    protected:
-        FieldGetter mGetter;
-        FieldSetter mSetter;
-    };
+template <typename T, typename FT, FT T::*Member,
+          typename SerT = TypeSerializer<FT>>
+struct StructField {
+    typedef FT Type;
+
+    /// Stored size of the field in bytes
+    static const size_t storedSize = SerializerTraits<SerT>::storedSize;
+
+    static_assert(storedSize > 0,
+                  "Struct storage fields have to have a fixed stored size");
+
+    static void read(FilePtr &src, T &data) {
+        SerT ser;
+        ser.SerT::deserialize(src, &(data.*Member));
+    }
+
+    static void read(FileSpan &src, T &data) {
+        SerT ser;
+        ser.SerT::deserialize(src, &(data.*Member));
+    }
+
+    static void write(FilePtr &dest, const T &data) {
+        SerT ser;
+        ser.SerT::serialize(dest, &(data.*Member));
+    }
+
+    static void get(const T &data, Variant &val) { val = data.*Member; }
+
+    static void set(T &data, const Variant &val) {
+        data.*Member = val.as<FT>();
+    }
+
+    static DataFieldDesc describe(const char *name) {
+        DataFieldDesc fd;
+
+        fd.name = name;
+        fd.label = name;
+        fd.size = sizeof(FT);
+        fd.enumerator = NULL;
+        fd.type = VariantTypeTraits<FT>::type;
+
+        return fd;
+    }
+};
+
+/// Declares the StructField of the member M of struct S
+#define OPDE_STRUCT_FIELD(S, M) Opde::StructField<S, decltype(S::M), &S::M>
+
+/** Compile time list of the fields of a struct, in the stored order. All the
+ * per field operations unroll into direct, non-virtual code.
+ * @param T The struct type
+ * @param Fields The StructField descriptions of the fields
+ */
+template <typename T, typename... Fields> struct StructFieldList;
+
+template <typename T> struct StructFieldList<T> {
+    static const size_t count = 0;
+    static const size_t storedSize = 0;
+
+    static void read(FilePtr &src, T &data) {}
+    static void read(FileSpan &src, T &data) {}
+    static void write(FilePtr &dest, const T &data) {}
 
-    typedef std::unordered_map<std::string, TypeHelperBasePtr> TypeHelperMap;
+    static bool get(size_t index, const T &data, Variant &val) {
+        return false;
+    }
+
+    static bool set(size_t index, T &data, const Variant &val) {
+        return false;
+    }
+
+    static void describe(DataFields &fields, const char *const *names) {}
+};
+
+template <typename T, typename F, typename... Rest>
+struct StructFieldList<T, F, Rest...> {
+    typedef StructFieldList<T, Rest...> Tail;
+
+    /// Count of the fields
+    static const size_t count = 1 + Tail::count;
+
+    /// Stored size of the whole struct in bytes
+    static const size_t storedSize = F::storedSize + Tail::storedSize;
+
+    /// Deserializes all the fields
+    static void read(FilePtr &src, T &data) {
+        F::read(src, data);
+        Tail::read(src, data);
+    }
+
+    /// Deserializes all the fields from a span
+    static void read(FileSpan &src, T &data) {
+        F::read(src, data);
+        Tail::read(src, data);
+    }
+
+    /// Serializes all the fields
+    static void write(FilePtr &dest, const T &data) {
+        F::write(dest, data);
+        Tail::write(dest, data);
+    }
+
+    /// Field value getter by the field index. @return false if out of range
+    static bool get(size_t index, const T &data, Variant &val) {
+        if (index == 0) {
+            F::get(data, val);
+            return true;
+        }
 
-    TypeHelperMap mTypeHelpers;
+        return Tail::get(index - 1, data, val);
+    }
+
+    /// Field value setter by the field index. @return false if out of range
+    static bool set(size_t index, T &data, const Variant &val) {
+        if (index == 0) {
+            F::set(data, val);
+            return true;
+        }
 
+        return Tail::set(index - 1, data, val);
+    }
+
+    /// Fills the field descriptions, names given in the field order
+    static void describe(DataFields &fields, const char *const *names) {
+        fields.push_back(F::describe(names[0]));
+        Tail::describe(fields, names + 1);
+    }
+};
+
+/** Common ancestor template for all the struct based data storages. The
+ * fields of the struct are described at compile time by a StructFieldList,
+ * their names are given to the constructor:
+ * @code
+ * typedef StructFieldList<sFoo, OPDE_STRUCT_FIELD(sFoo, a),
+ *                         OPDE_STRUCT_FIELD(sFoo, b)> FooFields;
+ *
+ * FooStorage::FooStorage() : StructDataStorage({"a", "b"}) {}
+ * @endcode
+ * @param T The struct type
+ * @param FieldsT The StructFieldList of the struct's fields
+ * @param DataMapT The container of the values. Storages of properties present
+ * on most of the objects should use DenseDataMap<T>
+ * @note The field enumerators can be set on mFieldDesc by the descendants
+ */
+template <typename T, typename FieldsT, typename DataMapT = std::map<int, T>>
+class StructDataStorage : public DataStorage {
 public:
+    /// The field list
+    typedef FieldsT Fields;
+
     /** @see DataStorage::create */
     virtual bool create(int objID) {
         // call _create to handle the creation, with the default value
@@ -150,34 +234,37 @@ public:
     /** @see DataStorage::getField */
     virtual bool getField(int objID, const std::string &field,
                           Variant &target) {
-        typename DataMap::iterator it = mDataMap.find(objID);
-
-        if (it != mDataMap.end()) {
-            typename TypeHelperMap::iterator tit = mTypeHelpers.find(field);
-
-            if (tit != mTypeHelpers.end()) {
-                return (*this.*(tit->second->getter()))(tit->second, it->second,
-                                                        target);
-            }
-        }
-
-        return false;
+        return getField(objID, getFieldHandle(field), target);
     }
 
     /** @see DataStorage::setField */
     virtual bool setField(int objID, const std::string &field,
                           const Variant &value) {
+        return setField(objID, getFieldHandle(field), value);
+    }
+
+    /** @see DataStorage::getField(int, FieldHandle, Variant &) */
+    virtual bool getField(int objID, FieldHandle field, Variant &target) {
+        if (!field.isValid())
+            return false;
+
         typename DataMap::iterator it = mDataMap.find(objID);
 
-        if (it != mDataMap.end()) {
+        if (it != mDataMap.end())
+            return Fields::get(field.index(), it->second, target);
+
+        return false;
+    }
 
-            typename TypeHelperMap::iterator tit = mTypeHelpers.find(field);
+    /** @see DataStorage::setField(int, FieldHandle, const Variant &) */
+    virtual bool setField(int objID, FieldHandle field, const Variant &value) {
+        if (!field.isValid())
+            return false;
 
-            if (tit != mTypeHelpers.end()) {
-                return (*this.*(tit->second->setter()))(tit->second, it->second,
-                                                        value);
-            }
-        }
+        typename DataMap::iterator it = mDataMap.find(objID);
+
+        if (it != mDataMap.end())
+            return Fields::set(field.index(), it->second, value);
 
         return false;
     }
@@ -187,20 +274,13 @@ public:
         typename DataMap::iterator it = mDataMap.find(objID);
 
         if (it != mDataMap.end()) {
-            const T &dta = it->second;
-
-            uint32_t size = mStoredSize;
+            uint32_t size = Fields::storedSize;
 
             // Write the size if requested
             if (sizeStored)
                 file->writeElem(&size, sizeof(uint32_t));
 
-            const auto &fields = getFieldDesc();
-
-            for(const auto &field : fields) {
-                TypeHelperBasePtr thb = mTypeHelpers[field.name];
-                thb->getSerializer()->serialize(file, thb->getFieldPtr(dta));
-            }
+            Fields::write(file, it->second);
 
             return true;
         }
@@ -213,21 +293,16 @@ public:
         typename DataMap::iterator it = mDataMap.find(objID);
 
         if (it == mDataMap.end()) {
-            uint32_t size = sizeof(T);
+            uint32_t size = Fields::storedSize;
 
             if (sizeStored)
                 file->readElem(&size, sizeof(uint32_t));
 
-            assert(size == mStoredSize);
+            assert(size == Fields::storedSize);
 
             T dta;
 
-            // iterate over the fields
-            const auto &fields = getFieldDesc();
-            for(const auto &field : fields) {
-                TypeHelperBasePtr thb = mTypeHelpers[field.name];
-                thb->getSerializer()->deserialize(file, thb->getFieldPtr(dta));
-            }
+            Fields::read(file, dta);
 
             _create(objID, dta);
 
@@ -243,17 +318,46 @@ public:
         return false;
     }
 
+    /** @see DataStorage::getStoredSize */
+    virtual size_t getStoredSize(void) { return Fields::storedSize; }
+
+    /** @see DataStorage::readFromSpan */
+    virtual bool readFromSpan(FileSpan &span, int objID) {
+        if (mDataMap.find(objID) != mDataMap.end()) {
+            // skip the data...
+            span.skip(Fields::storedSize);
+            return false;
+        }
+
+        T dta;
+
+        Fields::read(span, dta);
+
+        return _create(objID, dta);
+    }
+
     /** @see DataStorage::clear */
     virtual void clear() { mDataMap.clear(); }
 
     /** @see DataStorage::isEmpty */
     virtual bool isEmpty() { return mDataMap.empty(); }
 
+    /** @see DataStorage::grow */
+    virtual void grow(int minID, int maxID) {
+        growDataMap(mDataMap, minID, maxID);
+    }
+
     /** @see DataStorage::getAllStoredObjects */
     virtual IntIteratorPtr getAllStoredObjects() {
         return IntIteratorPtr(new DataMapKeyIterator(mDataMap));
     }
 
+    /** @see DataStorage::forEachStored */
+    virtual void forEachStored(const ObjectVisitor &visitor) {
+        for (const auto &val : mDataMap)
+            visitor(val.first);
+    }
+
     /** Core Data creation routine */
     virtual bool _create(int objID, const T &val) {
         std::pair<typename DataMap::iterator, bool> res =
@@ -270,90 +374,34 @@ public:
     /** @see DataStorage::getDataSize */
     virtual size_t getDataSize(void) { return sizeof(T); }
 
-protected:
-    template <typename FT> class TypeHelper : public TypeHelperBase {
-    public:
-        typedef FT T::*StructField;
-
-        TypeHelper(StructField fieldPtr, FieldGetter getter, FieldSetter setter)
-            : TypeHelperBase(getter, setter), mField(fieldPtr) {}
-
-        virtual ~TypeHelper() { }
-
-        virtual void toField(T &data, const Variant &val) {
-            data.*mField = val.as<FT>();
-        }
-
-        virtual void fromField(const T &data, Variant &val) {
-            val = Variant(data.*mField);
-        };
-
-        virtual Serializer *getSerializer() { return &mSerializer; }
-
-        virtual void *getFieldPtr(T &data) { return &(data.*mField); };
-
-        virtual const void *getFieldPtr(const T &data) const {
-            return &(data.*mField);
-        };
-
-    protected:
-        TypeSerializer<FT> mSerializer;
-        StructField mField;
-    };
-
-    // --- default field handlers ---
+    /** @see DataStorage::getDataPtr */
+    virtual const void *getDataPtr(int objID) {
+        typename DataMap::const_iterator it = mDataMap.find(objID);
 
-    /// Default field setter. Used when no other specified
-    bool defaultFieldSetter(const TypeHelperBasePtr &helper, T &data,
-                            const Variant &value) {
-        helper->toField(data, value);
-        return true;
-    }
+        if (it != mDataMap.end())
+            return &it->second;
 
-    /// Default field getter. Used when no other specified
-    bool defaultFieldGetter(const TypeHelperBasePtr &helper, const T &data,
-                            Variant &value) {
-        helper->fromField(data, value);
-        return true;
+        return NULL;
     }
 
-    template <typename FT>
-    void field(const std::string &name, FT T::*fieldPtr,
-               Enumeration *enumer = NULL, FieldGetter getter = NULL,
-               FieldSetter setter = NULL)
-    {
-        // insert into the field def array.
-        DataFieldDesc fd;
-
-        fd.name = name;
-        fd.label = name;
-        fd.size = sizeof(FT);
-        fd.enumerator = enumer;
-        fd.type = VariantTypeTraits<FT>::type;
-
-        mFieldDesc.push_back(fd);
+    /** @see DataStorage::getDataType */
+    virtual const std::type_info &getDataType(void) { return typeid(T); }
 
-        if (getter == NULL)
-            getter = &StructDataStorage::defaultFieldGetter;
-
-        if (setter == NULL)
-            setter = &StructDataStorage::defaultFieldSetter;
-
-        // data manipulation helper
-        TypeHelperBasePtr thb(new TypeHelper<FT>(fieldPtr, getter, setter));
-        mTypeHelpers[name] = thb;
-
-        mStoredSize += thb->getSerializer()->getStoredSize(0);
-    };
-
-    explicit StructDataStorage() {
-        mStoredSize = 0; // incremented in field method.
+protected:
+    /** Constructor
+     * @param names The names of the fields, in the FieldsT order */
+    template <size_t N>
+    explicit StructDataStorage(const char *const (&names)[N]) {
+        static_assert(N == Fields::count,
+                      "A name has to be given for every field");
+
+        Fields::describe(mFieldDesc, names);
     };
 
     virtual ~StructDataStorage() {}
 
     /// Data map
-    typedef typename std::map<int, T> DataMap;
+    typedef DataMapT DataMap;
 
     /// Holder of data values
     DataMap mDataMap;
@@ -361,8 +409,6 @@ protected:
     DataFields mFieldDesc;
 
     typedef MapKeyIterator<DataMap, int> DataMapKeyIterator;
-
-    size_t mStoredSize;
 };
 } // namespace Opde
 
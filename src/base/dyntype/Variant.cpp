@@ -22,6 +22,7 @@
  *****************************************************************************/
 
 #include "Variant.h"
+#include <cstring>
 #include <stdexcept>
 
 using namespace std;
@@ -60,20 +61,21 @@ Variant::Variant(Type t, void *val) {
         break;
 
     case DV_STRING:
-        mPrivate.data.shared = new Shared<string>(*static_cast<string *>(val));
-        mPrivate.isShared = 1;
+        if (val) {
+            const string &text = *static_cast<string *>(val);
+            setString(text.data(), text.length());
+        } else {
+            setString("", 0);
+        }
         break;
 
     case DV_VECTOR:
-        mPrivate.data.shared =
-            new Shared<Vector3>(*static_cast<Vector3 *>(val));
-        mPrivate.isShared = 1;
+        setVector(val ? *static_cast<Vector3 *>(val) : Vector3::ZERO);
         break;
 
     case DV_QUATERNION:
-        mPrivate.data.shared =
-            new Shared<Quaternion>(*static_cast<Quaternion *>(val));
-        mPrivate.isShared = 1;
+        setQuaternion(val ? *static_cast<Quaternion *>(val)
+                          : Quaternion::IDENTITY);
         break;
 
     default:
@@ -104,19 +106,15 @@ Variant::Variant(Type t, const std::string &txtval) {
         break;
 
     case DV_STRING:
-        mPrivate.data.shared = new Shared<string>(txtval);
-        mPrivate.isShared = true;
+        setString(txtval.data(), txtval.length());
         break;
 
     case DV_VECTOR:
-        mPrivate.data.shared = new Shared<Vector3>(StringToVector(txtval));
-        mPrivate.isShared = true;
+        setVector(StringToVector(txtval));
         break;
 
     case DV_QUATERNION:
-        mPrivate.data.shared =
-            new Shared<Quaternion>(StringToQuaternion(txtval));
-        mPrivate.isShared = true;
+        setQuaternion(StringToQuaternion(txtval));
         break;
 
     default:
@@ -126,13 +124,19 @@ Variant::Variant(Type t, const std::string &txtval) {
 
 //------------------------------------
 Variant::Variant(const Variant &b) {
-    if (b.mPrivate.isShared) {
-        mPrivate.isShared = true;
-        mPrivate.type = b.mPrivate.type;
+    mPrivate = b.mPrivate;
+
+    if (b.mPrivate.isShared)
         mPrivate.data.shared = b.mPrivate.data.shared->clone();
-    } else {
-        mPrivate = b.mPrivate;
-    }
+}
+
+//------------------------------------
+Variant::Variant(Variant &&b) noexcept {
+    mPrivate = b.mPrivate;
+
+    // b's shared data (if any) is ours now
+    b.mPrivate.isShared = false;
+    b.mPrivate.type = DV_INVALID;
 }
 
 //------------------------------------
@@ -166,57 +170,49 @@ Variant::Variant(uint val) {
 //------------------------------------
 Variant::Variant(const char *text, int length) {
     mPrivate.type = DV_STRING;
+    mPrivate.isShared = false;
 
     if (length > 0) { // if length is present... (I could probably see what the
                       // default length param is, but it could differ)
-        mPrivate.data.shared = new Shared<string>(string(text, length));
+        setString(text, length);
     } else {
-        mPrivate.data.shared = new Shared<string>(text);
+        setString(text, strlen(text));
     }
-
-    mPrivate.isShared = true;
 }
 
 //------------------------------------
 Variant::Variant(const std::string &text) {
     mPrivate.type = DV_STRING;
-    mPrivate.data.shared = new Shared<string>(text);
-    mPrivate.isShared = true;
+    mPrivate.isShared = false;
+    setString(text.data(), text.length());
 }
 
 //------------------------------------
 Variant::Variant(const Vector3 &vec) {
-    mPrivate.type = DV_VECTOR;
-    mPrivate.data.shared = new Shared<Vector3>(vec);
-    mPrivate.isShared = true;
+    mPrivate.isShared = false;
+    setVector(vec);
 }
 
 //------------------------------------
 Variant::Variant(const Quaternion &ori) {
-    mPrivate.type = DV_QUATERNION;
-    mPrivate.data.shared = new Shared<Quaternion>(ori);
-    mPrivate.isShared = true;
+    mPrivate.isShared = false;
+    setQuaternion(ori);
 }
 
 //------------------------------------
 Variant::Variant(float x, float y, float z) {
-    mPrivate.type = DV_VECTOR;
-    mPrivate.data.shared = new Shared<Vector3>(Vector3(x, y, z));
-    mPrivate.isShared = true;
+    mPrivate.isShared = false;
+    setVector(Vector3(x, y, z));
 }
 
 //------------------------------------
 Variant::Variant(float x, float y, float z, float w) {
-    mPrivate.type = DV_QUATERNION;
-    mPrivate.data.shared = new Shared<Quaternion>(Quaternion(x, y, z, w));
-    mPrivate.isShared = true;
+    mPrivate.isShared = false;
+    setQuaternion(Quaternion(x, y, z, w));
 }
 
 //------------------------------------
-Variant::~Variant() {
-    if (mPrivate.isShared)
-        delete mPrivate.data.shared;
-}
+Variant::~Variant() { release(); }
 
 //------------------------------------
 const char *Variant::typeString() const { return typeToString(mPrivate.type); }
@@ -245,41 +241,49 @@ const char *Variant::typeToString(Variant::Type t) {
 
 //------------------------------------
 Variant::operator std::string() const {
-    std::ostringstream o;
-
     switch (mPrivate.type) {
     case DV_BOOL:
         return mPrivate.data.dbool ? "true" : "false";
+    case DV_STRING:
+        return stringValue();
+    case DV_INVALID:
+        // TODO: We need a good replacement for exceptions here (and everywhere
+        // else as well) I assert false for now...
+        assert(false);
+        return "<INVALID_TYPE>";
+    default:
+        break;
+    }
+
+    // only the numeric types need the stream
+    std::ostringstream o;
+
+    switch (mPrivate.type) {
     case DV_FLOAT:
         o << mPrivate.data.dfloat;
-        return o.str();
+        break;
     case DV_INT:
         o << mPrivate.data.dint;
-        return o.str();
+        break;
     case DV_UINT:
         o << mPrivate.data.duint;
-        return o.str();
-    case DV_STRING:
-        assert(mPrivate.isShared);
-        return (static_cast<Shared<string> *>(mPrivate.data.shared))->data;
+        break;
     case DV_VECTOR: {
-        const Vector3 &vecd =
-            (static_cast<Shared<Vector3> *>(mPrivate.data.shared))->data;
-        o << vecd.x << ", " << vecd.y << ", " << vecd.z;
-        return o.str();
+        const float *vecd = mPrivate.data.dvector;
+        o << vecd[0] << ", " << vecd[1] << ", " << vecd[2];
+        break;
     }
     case DV_QUATERNION: {
-        const Quaternion &qd =
-            (static_cast<Shared<Quaternion> *>(mPrivate.data.shared))->data;
-        o << qd.w << ", " << qd.x << ", " << qd.y << ", " << qd.z;
-        return o.str();
+        const float *qd = mPrivate.data.dquaternion;
+        o << qd[0] << ", " << qd[1] << ", " << qd[2] << ", " << qd[3];
+        break;
     }
     default:
-        // TODO: We need a good replacement for exceptions here (and everywhere
-        // else as well) I assert false for now...
         assert(false);
         return "<INVALID_TYPE>";
     }
+
+    return o.str();
 }
 
 //------------------------------------
@@ -287,8 +291,6 @@ string Variant::toString() const { return operator string(); }
 
 //------------------------------------
 int Variant::toInt() const {
-    std::stringstream ssStream;
-
     switch (mPrivate.type) {
     case DV_BOOL:
         return mPrivate.data.dbool ? 1 : 0;
@@ -299,8 +301,7 @@ int Variant::toInt() const {
     case DV_UINT:
         return mPrivate.data.duint;
     case DV_STRING: // Convert the contained value to string
-        return StringToInt(
-            ((static_cast<Shared<string> *>(mPrivate.data.shared))->data));
+        return StringToInt(stringValue());
     case DV_VECTOR:
         throw runtime_error(
             "Variant::toInt() - vector cannot be converted to int");
@@ -326,8 +327,7 @@ uint Variant::toUInt() const {
     case DV_UINT:
         return mPrivate.data.duint;
     case DV_STRING:
-        return StringToInt(
-            ((static_cast<Shared<string> *>(mPrivate.data.shared))->data));
+        return StringToInt(stringValue());
     case DV_VECTOR:
         throw runtime_error(
             "Variant::toUInt() - vector cannot be converted to uint");
@@ -341,8 +341,6 @@ uint Variant::toUInt() const {
 
 //------------------------------------
 float Variant::toFloat() const {
-    std::stringstream ssStream;
-
     switch (mPrivate.type) {
     case DV_BOOL:
         return mPrivate.data.dbool ? 1 : 0;
@@ -353,8 +351,7 @@ float Variant::toFloat() const {
     case DV_UINT:
         return mPrivate.data.duint;
     case DV_STRING:
-        return StringToFloat(
-            (static_cast<Shared<string> *>(mPrivate.data.shared))->data);
+        return StringToFloat(stringValue());
     case DV_VECTOR:
         throw runtime_error(
             "Variant::toFloat() - vector cannot be converted to int");
@@ -378,8 +375,7 @@ bool Variant::toBool() const {
     case DV_UINT:
         return mPrivate.data.duint != 0;
     case DV_STRING:
-        return StringToBool(
-            (static_cast<Shared<string> *>(mPrivate.data.shared))->data);
+        return StringToBool(stringValue());
     case DV_VECTOR:
         throw runtime_error(
             "Variant::toBool() - vector cannot be converted to bool");
@@ -395,10 +391,9 @@ bool Variant::toBool() const {
 Vector3 Variant::toVector() const {
     if (mPrivate.type == DV_VECTOR) {
         // simply return the value
-        return ((static_cast<Shared<Vector3> *>(mPrivate.data.shared))->data);
+        return vectorValue();
     } else if (mPrivate.type == DV_STRING) {
-        return StringToVector(
-            (static_cast<Shared<string> *>(mPrivate.data.shared))->data);
+        return StringToVector(stringValue());
     } else {
         throw runtime_error("Variant::toVector - Incompatible source type");
     }
@@ -408,11 +403,9 @@ Vector3 Variant::toVector() const {
 Quaternion Variant::toQuaternion() const {
     if (mPrivate.type == DV_QUATERNION) {
         // simply return the value
-        return (
-            (static_cast<Shared<Quaternion> *>(mPrivate.data.shared))->data);
+        return quaternionValue();
     } else if (mPrivate.type == DV_STRING) {
-        return StringToQuaternion(
-            (static_cast<Shared<string> *>(mPrivate.data.shared))->data);
+        return StringToQuaternion(stringValue());
     } else {
         throw runtime_error(
             "Variant::toQuaternion - Incompatible source type");
@@ -421,39 +414,40 @@ Quaternion Variant::toQuaternion() const {
 
 //------------------------------------
 const Variant &Variant::operator=(const Variant &b) {
-    // The rather unreadable ugly code is here to handle to self-asignment
-    if (b.mPrivate.isShared) {
-
-        if ((mPrivate.isShared)) {
-            // we have shared data as well
-            if ((mPrivate.data.shared != b.mPrivate.data.shared)) {
-                // only copy data if not the same pointer
-                delete mPrivate.data.shared;
-                mPrivate.data.shared = b.mPrivate.data.shared->clone();
-            }
-        } else // we did not have shared data, clone no matter what
-            mPrivate.data.shared = b.mPrivate.data.shared->clone();
+    // self-asignment would release the data we're about to clone
+    if (this == &b)
+        return *this;
 
-        mPrivate.isShared = true;
-        mPrivate.type = b.mPrivate.type;
+    release();
 
-    } else {
-        // if was shared, release
-        if (mPrivate.isShared)
-            delete mPrivate.data.shared;
+    mPrivate = b.mPrivate;
 
-        mPrivate = b.mPrivate;
-    }
+    if (b.mPrivate.isShared)
+        mPrivate.data.shared = b.mPrivate.data.shared->clone();
+
+    return *this;
+}
+
+//------------------------------------
+const Variant &Variant::operator=(Variant &&b) noexcept {
+    if (this == &b)
+        return *this;
+
+    release();
+
+    mPrivate = b.mPrivate;
+
+    // b's shared data (if any) is ours now
+    b.mPrivate.isShared = false;
+    b.mPrivate.type = DV_INVALID;
 
     return *this;
 }
 
 //------------------------------------
 const Variant &Variant::operator=(bool b) {
-    if (mPrivate.isShared)
-        delete mPrivate.data.shared;
+    release();
 
-    mPrivate.isShared = false;
     mPrivate.data.dbool = b;
     mPrivate.type = DV_BOOL;
 
@@ -462,11 +456,9 @@ const Variant &Variant::operator=(bool b) {
 
 //------------------------------------
 const Variant &Variant::operator=(int i) {
-    if (mPrivate.isShared)
-        delete mPrivate.data.shared;
+    release();
 
     mPrivate.type = DV_INT;
-    mPrivate.isShared = false;
     mPrivate.data.dint = i;
 
     return *this;
@@ -474,11 +466,9 @@ const Variant &Variant::operator=(int i) {
 
 //------------------------------------
 const Variant &Variant::operator=(uint u) {
-    if (mPrivate.isShared)
-        delete mPrivate.data.shared;
+    release();
 
     mPrivate.type = DV_UINT;
-    mPrivate.isShared = false;
     mPrivate.data.duint = u;
 
     return *this;
@@ -486,11 +476,9 @@ const Variant &Variant::operator=(uint u) {
 
 //------------------------------------
 const Variant &Variant::operator=(float f) {
-    if (mPrivate.isShared)
-        delete mPrivate.data.shared;
+    release();
 
     mPrivate.type = DV_FLOAT;
-    mPrivate.isShared = false;
     mPrivate.data.dfloat = f;
 
     return *this;
@@ -498,48 +486,30 @@ const Variant &Variant::operator=(float f) {
 
 //------------------------------------
 const Variant &Variant::operator=(const char *s) {
-    if (mPrivate.isShared)
-        delete mPrivate.data.shared;
-
-    mPrivate.isShared = true;
-    mPrivate.type = DV_STRING;
-    mPrivate.data.shared = new Shared<string>(string(s));
-
-    return *this;
+    // s could point into our own shared string
+    Variant tmp(s);
+    return operator=(std::move(tmp));
 }
 
 //------------------------------------
 const Variant &Variant::operator=(const std::string &s) {
-    if (mPrivate.isShared)
-        delete mPrivate.data.shared;
-
-    mPrivate.isShared = true;
-    mPrivate.type = DV_STRING;
-    mPrivate.data.shared = new Shared<string>(s);
-
-    return *this;
+    // s could be our own shared string
+    Variant tmp(s);
+    return operator=(std::move(tmp));
 }
 
 //------------------------------------
 const Variant &Variant::operator=(const Vector3 &v) {
-    if (mPrivate.isShared)
-        delete mPrivate.data.shared;
-
-    mPrivate.isShared = true;
-    mPrivate.type = DV_VECTOR;
-    mPrivate.data.shared = new Shared<Vector3>(v);
+    release();
+    setVector(v);
 
     return *this;
 }
 
 //------------------------------------
 const Variant &Variant::operator=(const Quaternion &q) {
-    if (mPrivate.isShared)
-        delete mPrivate.data.shared;
-
-    mPrivate.isShared = true;
-    mPrivate.type = DV_QUATERNION;
-    mPrivate.data.shared = new Shared<Quaternion>(q);
+    release();
+    setQuaternion(q);
 
     return *this;
 }
@@ -563,6 +533,71 @@ template <typename T> T &Variant::shared_cast() const {
             "Invalid shared_cast - cast on different type or NULL"));
 }
 
+//------------------------------------
+void Variant::release() {
+    if (mPrivate.isShared)
+        delete mPrivate.data.shared;
+
+    mPrivate.isShared = false;
+}
+
+//------------------------------------
+void Variant::setString(const char *text, size_t length) {
+    mPrivate.type = DV_STRING;
+
+    if (length <= SMALL_STRING_SIZE) {
+        memcpy(mPrivate.data.dstring, text, length);
+        mPrivate.strLength = static_cast<uint8_t>(length);
+        mPrivate.isShared = false;
+    } else {
+        mPrivate.data.shared = new Shared<string>(string(text, length));
+        mPrivate.isShared = true;
+    }
+}
+
+//------------------------------------
+void Variant::setVector(const Vector3 &vec) {
+    mPrivate.type = DV_VECTOR;
+    mPrivate.data.dvector[0] = vec.x;
+    mPrivate.data.dvector[1] = vec.y;
+    mPrivate.data.dvector[2] = vec.z;
+}
+
+//------------------------------------
+void Variant::setQuaternion(const Quaternion &ori) {
+    mPrivate.type = DV_QUATERNION;
+    mPrivate.data.dquaternion[0] = ori.w;
+    mPrivate.data.dquaternion[1] = ori.x;
+    mPrivate.data.dquaternion[2] = ori.y;
+    mPrivate.data.dquaternion[3] = ori.z;
+}
+
+//------------------------------------
+std::string Variant::stringValue() const {
+    assert(mPrivate.type == DV_STRING);
+
+    if (mPrivate.isShared)
+        return shared_cast<string>();
+
+    return string(mPrivate.data.dstring, mPrivate.strLength);
+}
+
+//------------------------------------
+Vector3 Variant::vectorValue() const {
+    assert(mPrivate.type == DV_VECTOR);
+
+    const float *v = mPrivate.data.dvector;
+    return Vector3(v[0], v[1], v[2]);
+}
+
+//------------------------------------
+Quaternion Variant::quaternionValue() const {
+    assert(mPrivate.type == DV_QUATERNION);
+
+    const float *q = mPrivate.data.dquaternion;
+    return Quaternion(q[0], q[1], q[2], q[3]);
+}
+
 //------------------------------------
 bool Variant::compare(const Variant &b) const {
     if (b.type() == type()) {
@@ -576,12 +611,12 @@ bool Variant::compare(const Variant &b) const {
         case DV_UINT:
             return b.mPrivate.data.duint == mPrivate.data.duint;
         case DV_STRING:
-            return b.shared_cast<string>() == shared_cast<string>();
+            return b.stringValue() == stringValue();
         case DV_VECTOR:
-            return b.shared_cast<Vector3>() == shared_cast<Vector3>();
+            return b.vectorValue() == vectorValue();
 
         case DV_QUATERNION:
-            return b.shared_cast<Quaternion>() == shared_cast<Quaternion>();
+            return b.quaternionValue() == quaternionValue();
 
         default:
             throw(runtime_error("Variant: Invalid compare type"));
@@ -601,13 +636,13 @@ bool Variant::compare(const Variant &b) const {
             return toInt() == b.toInt();
 
         case DV_STRING:
-            return shared_cast<string>() == b.toString();
+            return stringValue() == b.toString();
 
         case DV_VECTOR:
-            return shared_cast<Vector3>() == b.toVector();
+            return vectorValue() == b.toVector();
 
         case DV_QUATERNION:
-            return shared_cast<Quaternion>() == b.toQuaternion();
+            return quaternionValue() == b.toQuaternion();
 
         default:
             throw runtime_error("Variant::typeToString() - invalid type");
@@ -53,12 +53,12 @@ public:
         DV_INT = 3,
         /** Unsigned int type */
         DV_UINT = 4,
-        // Shared pointer types start here:
-        /** String type. Shared */
+        /** String type. Stored inline up to SMALL_STRING_SIZE bytes, shared
+           otherwise */
         DV_STRING = 5,
-        /** Vector type. Shared */
+        /** Vector type */
         DV_VECTOR = 6,
-        /** Quaternion type. Shared */
+        /** Quaternion type */
         DV_QUATERNION = 7
     } Type;
 
@@ -78,10 +78,14 @@ public:
 
     /** Copy constructor
      * @param b The variant to copy the value from
-     * @note If the source variant is shared valued, only pointer to private
-     * data is copied, and reference is incremented */
+     * @note Only the long strings are held in a shared block, which is cloned
+     */
     Variant(const Variant &b);
 
+    /** Move constructor. Takes over the value of b, leaving it invalid
+     * @param b The variant to move the value from */
+    Variant(Variant &&b) noexcept;
+
     /** Bool constructor
      * @param val The value to use */
     Variant(bool val);
@@ -173,6 +177,10 @@ public:
     /** Asignment operator. Shared pointers are released if needed */
     const Variant &operator=(const Variant &b);
 
+    /** Move asignment operator. Takes over the value of b, leaving it invalid
+     */
+    const Variant &operator=(Variant &&b) noexcept;
+
     /** Asignment operator */
     const Variant &operator=(bool b);
     /** Asignment operator */
@@ -217,8 +225,8 @@ public:
         OPDE_EXCEPT("Invalid Variant as<>() cast");
     }
 
-    /** Templated shared type for Variant. Holds values for the shared types
-     * (string,vector) */
+    /** Templated shared type for Variant. Holds the values too large to be
+     * stored inline (long strings) */
     template <typename T> class Shared : public SharedBase {
     public:
         /// Constructor
@@ -238,18 +246,34 @@ public:
         T data;
     };
 
-    /** Private data holder. Holds either shared or non-shared value */
+    /// Length of the strings still stored inline. Matches the std::string
+    /// small buffer, so getting such a string does not allocate either
+    static const size_t SMALL_STRING_SIZE = 15;
+
+    /** Private data holder. Holds either shared or non-shared value. All the
+     * types but long strings are stored inline, so copying such variants does
+     * not allocate */
     struct Private {
         union Data {
             bool dbool;
             float dfloat;
             int dint;
             uint duint;
+            /// DV_VECTOR - x, y, z
+            float dvector[3];
+            /// DV_QUATERNION - w, x, y, z
+            float dquaternion[4];
+            /// DV_STRING of at most SMALL_STRING_SIZE bytes (not terminated)
+            char dstring[SMALL_STRING_SIZE];
+            /// DV_STRING longer than SMALL_STRING_SIZE
             SharedBase *shared;
         } data;
 
         Type type : 31;
         unsigned int isShared : 1;
+
+        /// Length of the inline stored string
+        uint8_t strLength;
     };
 
     // A const invalid dvariant. Can be used as a shortcut to be able to return
@@ -293,6 +317,27 @@ protected:
      * @return reference to the type T if possible. */
     template <typename T> T &shared_cast() const;
 
+    /// Releases the shared data, if any. The type is left unchanged
+    void release();
+
+    /// Sets a string value, inline if short enough
+    void setString(const char *text, size_t length);
+
+    /// Sets a vector value
+    void setVector(const Vector3 &vec);
+
+    /// Sets a quaternion value
+    void setQuaternion(const Quaternion &ori);
+
+    /// The string value. Only valid for DV_STRING
+    std::string stringValue() const;
+
+    /// The vector value. Only valid for DV_VECTOR
+    Vector3 vectorValue() const;
+
+    /// The quaternion value. Only valid for DV_QUATERNION
+    Quaternion quaternionValue() const;
+
     /** The comparison function. Is called by == and != operators */
     bool compare(const Variant &b) const;
 
@@ -22,14 +22,60 @@
  *****************************************************************************/
 
 #include "File.h"
+#include "NonCopyable.h"
 #include "config.h"
 #include <OgreLogManager.h>
 
+#include <algorithm>
+#include <cstring>
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 using namespace std;
 using namespace Ogre;
 
 namespace Opde {
 
+/*------------------------------------------------------*/
+/*----------------------- FileSpan ---------------------*/
+/*------------------------------------------------------*/
+const char *FileSpan::skip(file_size_t size) {
+    if (mPos + size > mSize)
+        OPDE_FILEEXCEPT(FILE_READ_ERROR, "Read past end of span",
+                        "FileSpan::skip()");
+
+    const char *ptr = mData + mPos;
+    mPos += size;
+    return ptr;
+}
+
+//------------------------------------
+FileSpan &FileSpan::read(void *buf, file_size_t size) {
+    memcpy(buf, skip(size), size);
+    return *this;
+}
+
+//------------------------------------
+FileSpan &FileSpan::readElem(void *buf, file_size_t size, uint count) {
+    read(buf, size * count);
+
+#ifdef __OPDE_BIG_ENDIAN
+    File::swapEndian(buf, size, count);
+#endif
+    return *this;
+}
+
 /*------------------------------------------------------*/
 /*------------------------- File -----------------------*/
 /*------------------------------------------------------*/
@@ -85,7 +131,7 @@ File &File::writeElem(const void *buf, file_size_t size, uint count) {
 
     swapEndian(copyb.get(), size, count);
 
-    write(copyb, bsize);
+    write(copyb.get(), bsize);
 #else
     write(buf, size * count);
 #endif
@@ -124,18 +170,46 @@ std::string File::getLine() {
 }
 
 //------------------------------------
-void File::swapEndian(void *buf, file_size_t size, uint count) {
-    // swap all elements
-    for (uint i = 0; i < count; i++) {
+FileSpan File::readSpan(file_size_t size) {
+    mSpanBuffer.resize(size);
 
-        char sw;
-        // swap the element's bytes
-        for (uint o = 0; o < size / 2; o++) {
-            sw = *(((char *)buf) + o);
+    if (size > 0)
+        read(mSpanBuffer.data(), size);
+
+    return FileSpan(mSpanBuffer.data(), size);
+}
 
-            *(((char *)buf) + o) = *(((char *)buf) + size - o - 1);
-            *(((char *)buf) + size - o - 1) = sw;
+//------------------------------------
+void File::swapEndian(void *buf, file_size_t size, file_size_t count) {
+    char *ptr = static_cast<char *>(buf);
+
+    // the common element sizes get unrolled swaps
+    switch (size) {
+    case 0:
+    case 1:
+        return;
+    case 2:
+        for (file_size_t i = 0; i < count; ++i, ptr += 2)
+            std::swap(ptr[0], ptr[1]);
+        return;
+    case 4:
+        for (file_size_t i = 0; i < count; ++i, ptr += 4) {
+            std::swap(ptr[0], ptr[3]);
+            std::swap(ptr[1], ptr[2]);
+        }
+        return;
+    case 8:
+        for (file_size_t i = 0; i < count; ++i, ptr += 8) {
+            std::swap(ptr[0], ptr[7]);
+            std::swap(ptr[1], ptr[6]);
+            std::swap(ptr[2], ptr[5]);
+            std::swap(ptr[3], ptr[4]);
         }
+        return;
+    default:
+        // swap all elements
+        for (file_size_t i = 0; i < count; ++i, ptr += size)
+            std::reverse(ptr, ptr + size);
     }
 }
 
@@ -272,8 +346,19 @@ StdFile::~StdFile() { mStream.close(); }
 
 //------------------------------------
 const file_size_t StdFile::size() {
-    OPDE_FILEEXCEPT(FILE_UNIMPL, "size method not implemented for StdFile",
-                    "StdFile.size()");
+    std::streampos cur = mStream.tellg();
+
+    mStream.seekg(0, ios_base::end);
+    std::streampos end = mStream.tellg();
+    mStream.seekg(cur);
+
+    if (mStream.fail() || end < 0) {
+        mStream.clear();
+        OPDE_FILEEXCEPT(FILE_OP_FAILED, "Could not determine the file size",
+                        "StdFile.size()");
+    }
+
+    return static_cast<file_size_t>(end);
 }
 
 //------------------------------------
@@ -406,22 +491,22 @@ bool OgreFile::eof() const { return mStream->eof(); }
 /*--------------------- MemoryFile ---------------------*/
 /*------------------------------------------------------*/
 MemoryFile::MemoryFile(const std::string &name, AccessMode mode)
-    : File(name, mode), mPages(), mSize(0), mFilePos(0), mEof(true) {}
+    : File(name, mode), mData(), mSize(0), mFilePos(0), mEof(true) {}
 
 //------------------------------------
-MemoryFile::~MemoryFile() {
-    mPages.clear();
-}
+MemoryFile::~MemoryFile() {}
 
 //------------------------------------
-std::pair<size_t, int> MemoryFile::decomposePos(file_pos_t pos) {
-    size_t page;
-    int pgpos;
+void MemoryFile::reserve(file_size_t size) {
+    if (size <= mData.size())
+        return;
+
+    // grow geometrically so repeated small writes stay amortized O(1)
+    file_size_t cap = std::max<file_size_t>(mData.size() * 2, MEMORY_FILE_MIN_CAPACITY);
 
-    page = pos / MEMORY_FILE_BUF_LEN;
-    pgpos = pos % MEMORY_FILE_BUF_LEN;
+    while (cap < size) cap *= 2;
 
-    return std::pair<size_t, int>(page, pgpos);
+    mData.resize(cap);
 }
 
 //------------------------------------
@@ -474,56 +559,20 @@ File &MemoryFile::read(void *buf, file_size_t size) {
 
 //------------------------------------
 File &MemoryFile::_read(void *buf, file_size_t size) {
-    file_size_t resSize = size;
-    file_size_t actp = mFilePos;
-
-    // actual position in the result buffer
-    char *ap = (char *)buf;
-
-    std::pair<size_t, int> pgp = decomposePos(actp);
-
-    unsigned int PagesSize = mPages.size();
-    while (resSize > 0) { // read from one page in one cycle pass
-        file_size_t read = 0;
-
-        char *page = mPages.at(pgp.first).get();
-
-        uint toEnd;
-
-        if (pgp.first >= PagesSize) { // last page. or error
-            toEnd = (mSize % MEMORY_FILE_BUF_LEN) - pgp.second;
-
-            if (toEnd == 0 || pgp.first >= PagesSize) {
-                // if this occurs, I've read the bytes I could
-                // I also should set the important member vars prior to
-                // exception throw
-                mEof = true;
-                mFilePos = mSize;
-
-                OPDE_FILEEXCEPT(FILE_READ_ERROR, "Read past end of file",
-                                "MemoryFile.read()");
-            }
-        } else {
-            toEnd = MEMORY_FILE_BUF_LEN - pgp.second;
-        }
-
-        read = (resSize > toEnd) ? toEnd : resSize;
-
-        memcpy((void *)ap, (void *)(&page[pgp.second]), read);
-
-        // increment the pointers and counts
-
-        pgp.first++; // Next page
-        pgp.second = 0;
+    if (mFilePos + size > mSize) {
+        // I also should set the important member vars prior to exception throw
+        mEof = true;
+        mFilePos = mSize;
 
-        ap += read;
-        actp += read;
-        resSize -= read;
-        mFilePos = actp;
+        OPDE_FILEEXCEPT(FILE_READ_ERROR, "Read past end of file",
+                        "MemoryFile.read()");
     }
 
-    if (mFilePos == mSize)
-        mEof = true;
+    if (size > 0)
+        memcpy(buf, mData.data() + mFilePos, size);
+
+    mFilePos += size;
+    mEof = (mFilePos >= mSize);
 
     return *this;
 }
@@ -539,78 +588,59 @@ File &MemoryFile::write(const void *buf, file_size_t size) {
 
 //------------------------------------
 File &MemoryFile::_write(const void *buf, file_size_t size) {
-    file_size_t resSize = size;
-    file_size_t actp = mFilePos;
+    reserve(mFilePos + size);
 
-    // actual position in the source buffer
-    std::pair<size_t, int> pgp = decomposePos(actp);
+    if (size > 0)
+        memcpy(mData.data() + mFilePos, buf, size);
 
-    unsigned int PagesSize = mPages.size();
-    while (resSize > 0) {
-        file_size_t written = 0;
-
-        if (pgp.first >=
-            PagesSize) { // I've finished the already allocated pages
-            std::unique_ptr<char[]> nbuf(new char[MEMORY_FILE_BUF_LEN]);
-
-            if (!nbuf) // this is quite fatal. something like out of disk space
-                OPDE_FILEEXCEPT(FILE_WRITE_ERROR,
-                                "Out of memory when allocating a new page",
-                                "MemoryFile.write()");
-
-            mPages.push_back(std::move(nbuf));
-        }
+    mFilePos += size;
 
-        char *page = mPages.at(pgp.first).get();
+    // file size validator
+    if (mSize < mFilePos) // past end write
+        mSize = mFilePos;
 
-        uint toEnd;
+    mEof = (mFilePos >= mSize);
 
-        toEnd = MEMORY_FILE_BUF_LEN - pgp.second;
+    return *this;
+}
 
-        written = (resSize > toEnd) ? toEnd : resSize;
+//------------------------------------
+bool MemoryFile::eof() const { return mEof; }
 
-        memcpy((void *)(&page[pgp.second]), buf, written);
+//------------------------------------
+void MemoryFile::writeToFile(File &dest) {
+    // the whole contents in one go, no intermediate copy
+    if (mSize > 0)
+        dest.write(mData.data(), mSize);
+}
 
-        // increment the pointers and counts
-        // next page
-        pgp.first++;
-        pgp.second = 0;
+//------------------------------------
+FileSpan MemoryFile::readSpan(file_size_t size) {
+    if (mFilePos + size > mSize)
+        OPDE_FILEEXCEPT(FILE_READ_ERROR, "Read past end of file",
+                        "MemoryFile::readSpan()");
 
-        buf = (char *)(buf) + written;
-        actp += written;
-        resSize -= written;
-        mFilePos = actp;
+    const char *ptr = mData.data() + mFilePos;
 
-        // file size validator
-        if (mSize < actp) { // past end write
-            mSize = actp;
-            mEof = true;
-        }
-    }
+    mFilePos += size;
+    mEof = (mFilePos >= mSize);
 
-    return *this;
+    return FileSpan(ptr, size);
 }
 
-//------------------------------------
-bool MemoryFile::eof() const { return mEof; }
-
 //------------------------------------
 void MemoryFile::initFromFile(File &src, file_size_t size) {
     if (mSize != 0)
         OPDE_FILEEXCEPT(FILE_WRITE_ERROR, "Can't do init on already used file",
                         "MemoryFile.initFromFile()");
 
-    while (size > 0) {
-        char temp[MEMORY_FILE_BUF_LEN];
-
-        file_size_t sz =
-            (size > MEMORY_FILE_BUF_LEN) ? MEMORY_FILE_BUF_LEN : size;
+    // exact fit, the file is not expected to grow
+    mData.resize(size);
 
-        src.read(temp, sz);
-        _write(temp, sz);
+    if (size > 0)
+        src.read(mData.data(), size);
 
-        size -= sz;
-    }
+    mSize = size;
 
     // go to the beginning of the file
     seek(0);
@@ -734,4 +764,387 @@ void FilePart::backupPos() { mPrevPos = mSrcFile->tell(); }
 
 //------------------------------------
 void FilePart::restorePos() { mSrcFile->seek(mPrevPos); }
+
+/*----------------------------------------------------*/
+/*--------------- MappedFile::Mapping ----------------*/
+/*----------------------------------------------------*/
+/// OS dependent memory mapping of a whole file (read only)
+class MappedFile::Mapping : public NonCopyable {
+public:
+    Mapping(const std::string &name);
+    ~Mapping();
+
+    const char *data() const { return mData; };
+
+    file_size_t size() const { return mSize; };
+
+private:
+    const char *mData;
+    file_size_t mSize;
+
+#ifdef WIN32
+    HANDLE mFile;
+    HANDLE mMap;
+#endif
+};
+
+#ifdef WIN32
+//------------------------------------
+MappedFile::Mapping::Mapping(const std::string &name)
+    : mData(NULL), mSize(0), mFile(INVALID_HANDLE_VALUE), mMap(NULL) {
+    mFile = CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (mFile == INVALID_HANDLE_VALUE)
+        OPDE_FILEEXCEPT(FILE_OPEN_ERROR, string("Could not open ") + name,
+                        "MappedFile::Mapping::Mapping()");
+
+    LARGE_INTEGER fsize;
+    if (!GetFileSizeEx(mFile, &fsize)) {
+        CloseHandle(mFile);
+        OPDE_FILEEXCEPT(FILE_OPEN_ERROR,
+                        string("Could not get the size of ") + name,
+                        "MappedFile::Mapping::Mapping()");
+    }
+
+    mSize = static_cast<file_size_t>(fsize.QuadPart);
+
+    // zero sized files can't be mapped, but there is nothing to read anyway
+    if (mSize == 0)
+        return;
+
+    mMap = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (mMap == NULL) {
+        CloseHandle(mFile);
+        OPDE_FILEEXCEPT(FILE_OPEN_ERROR, string("Could not map ") + name,
+                        "MappedFile::Mapping::Mapping()");
+    }
+
+    mData = static_cast<const char *>(
+        MapViewOfFile(mMap, FILE_MAP_READ, 0, 0, 0));
+
+    if (mData == NULL) {
+        CloseHandle(mMap);
+        CloseHandle(mFile);
+        OPDE_FILEEXCEPT(FILE_OPEN_ERROR, string("Could not map ") + name,
+                        "MappedFile::Mapping::Mapping()");
+    }
+}
+
+//------------------------------------
+MappedFile::Mapping::~Mapping() {
+    if (mData)
+        UnmapViewOfFile(mData);
+
+    if (mMap)
+        CloseHandle(mMap);
+
+    if (mFile != INVALID_HANDLE_VALUE)
+        CloseHandle(mFile);
+}
+#else
+//------------------------------------
+MappedFile::Mapping::Mapping(const std::string &name)
+    : mData(NULL), mSize(0) {
+    int fd = open(name.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        OPDE_FILEEXCEPT(FILE_OPEN_ERROR, string("Could not open ") + name,
+                        "MappedFile::Mapping::Mapping()");
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        OPDE_FILEEXCEPT(FILE_OPEN_ERROR,
+                        string("Could not get the size of ") + name,
+                        "MappedFile::Mapping::Mapping()");
+    }
+
+    mSize = static_cast<file_size_t>(st.st_size);
+
+    // zero sized files can't be mapped, but there is nothing to read anyway
+    if (mSize > 0) {
+        void *ptr = mmap(NULL, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (ptr == MAP_FAILED) {
+            close(fd);
+            OPDE_FILEEXCEPT(FILE_OPEN_ERROR, string("Could not map ") + name,
+                            "MappedFile::Mapping::Mapping()");
+        }
+
+        mData = static_cast<const char *>(ptr);
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+//------------------------------------
+MappedFile::Mapping::~Mapping() {
+    if (mData)
+        munmap(const_cast<char *>(mData), mSize);
+}
+#endif
+
+/*----------------------------------------------------*/
+/*-------------------- MappedFile --------------------*/
+/*----------------------------------------------------*/
+
+//------------------------------------
+MappedFile::MappedFile(const std::string &name)
+    : File(name, File::FILE_R), mMapping(new Mapping(name)), mFilePos(0) {
+    mData = mMapping->data();
+    mSize = mMapping->size();
+    mEof = (mSize <= mFilePos);
+}
+
+//------------------------------------
+MappedFile::MappedFile(const std::string &name, const MappedFile &parent,
+                       file_pos_t pos, file_size_t size)
+    : File(name, File::FILE_R), mMapping(parent.mMapping), mFilePos(0) {
+    if ((pos < 0) || (static_cast<file_size_t>(pos) + size > parent.mSize))
+        OPDE_FILEEXCEPT(FILE_OPEN_ERROR,
+                        string("View would reach past the end of ") +
+                            parent.mFileName,
+                        "MappedFile::MappedFile()");
+
+    mData = parent.mData + pos;
+    mSize = size;
+    mEof = (mSize <= mFilePos);
+}
+
+//------------------------------------
+MappedFile::~MappedFile() {}
+
+//------------------------------------
+const file_size_t MappedFile::size() { return mSize; }
+
+//------------------------------------
+void MappedFile::seek(file_offset_t pos, SeekMode mode) {
+    file_pos_t npos = mFilePos; // new position
+
+    switch (mode) {
+    case FSEEK_BEG:
+        npos = pos;
+        break;
+    case FSEEK_END:
+        npos = mSize - pos;
+        break;
+    case FSEEK_CUR:
+        npos += pos;
+        break;
+
+    default: // should not happen
+        OPDE_FILEEXCEPT(FILE_OTHER_ERROR, "Unknown seek position modifier",
+                        "MappedFile::seek()");
+    }
+
+    if ((npos < 0) || (static_cast<file_size_t>(npos) > mSize))
+        OPDE_FILEEXCEPT(FILE_OP_FAILED,
+                        "Resulting position not within the file size",
+                        "MappedFile::seek()");
+
+    mFilePos = npos;
+
+    mEof = (mFilePos >= mSize);
+}
+
+//------------------------------------
+void MappedFile::seek(file_pos_t pos) { seek(pos, FSEEK_BEG); }
+
+//------------------------------------
+const file_pos_t MappedFile::tell() { return mFilePos; }
+
+//------------------------------------
+File &MappedFile::read(void *buf, file_size_t size) {
+    if (mFilePos + size > mSize)
+        OPDE_FILEEXCEPT(FILE_READ_ERROR, "Read past end of file",
+                        "MappedFile::read()");
+
+    memcpy(buf, mData + mFilePos, size);
+
+    mFilePos += size;
+    mEof = (mFilePos >= mSize);
+
+    return *this;
+}
+
+//------------------------------------
+File &MappedFile::write(const void *buf, file_size_t size) {
+    OPDE_FILEEXCEPT(FILE_WRITE_ERROR, "Write not enabled on a MappedFile",
+                    "MappedFile::write()");
+}
+
+//------------------------------------
+bool MappedFile::eof() const { return mEof; }
+
+//------------------------------------
+FileSpan MappedFile::readSpan(file_size_t size) {
+    if (mFilePos + size > mSize)
+        OPDE_FILEEXCEPT(FILE_READ_ERROR, "Read past end of file",
+                        "MappedFile::readSpan()");
+
+    const char *ptr = mData + mFilePos;
+
+    mFilePos += size;
+    mEof = (mFilePos >= mSize);
+
+    return FileSpan(ptr, size);
+}
+
+/*----------------------------------------------------*/
+/*------------------- BufferedFile -------------------*/
+/*----------------------------------------------------*/
+
+//------------------------------------
+BufferedFile::BufferedFile(const FilePtr &src, file_size_t window)
+    : File(src->getName(), static_cast<AccessMode>(src->getAccessMode())),
+      mSrcFile(src), mBuffer(window), mBufPos(0), mBufLen(0) {
+    if (window == 0)
+        OPDE_FILEEXCEPT(FILE_OTHER_ERROR, "Zero sized read-ahead window",
+                        "BufferedFile::BufferedFile()");
+
+    mSize = mSrcFile->size();
+    mFilePos = static_cast<file_size_t>(mSrcFile->tell());
+}
+
+//------------------------------------
+BufferedFile::~BufferedFile() {}
+
+//------------------------------------
+const file_size_t BufferedFile::size() { return mSize; }
+
+//------------------------------------
+void BufferedFile::seek(file_offset_t pos, SeekMode mode) {
+    file_pos_t npos = mFilePos; // new position
+
+    switch (mode) {
+    case FSEEK_BEG:
+        npos = pos;
+        break;
+    case FSEEK_END:
+        npos = mSize - pos;
+        break;
+    case FSEEK_CUR:
+        npos += pos;
+        break;
+
+    default: // should not happen
+        OPDE_FILEEXCEPT(FILE_OTHER_ERROR, "Unknown seek position modifier",
+                        "BufferedFile::seek()");
+    }
+
+    if ((npos < 0) || (static_cast<file_size_t>(npos) > mSize))
+        OPDE_FILEEXCEPT(FILE_OP_FAILED,
+                        "Resulting position not within the file size",
+                        "BufferedFile::seek()");
+
+    // the buffer is kept, it may still cover the new position
+    mFilePos = npos;
+}
+
+//------------------------------------
+void BufferedFile::seek(file_pos_t pos) { seek(pos, FSEEK_BEG); }
+
+//------------------------------------
+const file_pos_t BufferedFile::tell() { return mFilePos; }
+
+//------------------------------------
+file_size_t BufferedFile::buffered() const {
+    if ((mFilePos < mBufPos) || (mFilePos >= mBufPos + mBufLen))
+        return 0;
+
+    return mBufPos + mBufLen - mFilePos;
+}
+
+//------------------------------------
+void BufferedFile::fill() {
+    mBufPos = mFilePos;
+    mBufLen = std::min<file_size_t>(mBuffer.size(), mSize - mFilePos);
+
+    if (mBufLen > 0) {
+        mSrcFile->seek(static_cast<file_pos_t>(mBufPos));
+        mSrcFile->read(mBuffer.data(), mBufLen);
+    }
+}
+
+//------------------------------------
+File &BufferedFile::read(void *buf, file_size_t size) {
+    if (mFilePos + size > mSize)
+        OPDE_FILEEXCEPT(FILE_READ_ERROR, "Read past end of file",
+                        "BufferedFile::read()");
+
+    char *dst = static_cast<char *>(buf);
+
+    // serve what is in the buffer already
+    file_size_t avail = std::min(buffered(), size);
+
+    if (avail > 0) {
+        memcpy(dst, mBuffer.data() + (mFilePos - mBufPos), avail);
+        dst += avail;
+        size -= avail;
+        mFilePos += avail;
+    }
+
+    if (size == 0)
+        return *this;
+
+    if (size >= mBuffer.size()) {
+        // big reads go straight to the destination
+        mSrcFile->seek(static_cast<file_pos_t>(mFilePos));
+        mSrcFile->read(dst, size);
+        mFilePos += size;
+    } else {
+        fill();
+        memcpy(dst, mBuffer.data(), size);
+        mFilePos += size;
+    }
+
+    return *this;
+}
+
+//------------------------------------
+File &BufferedFile::write(const void *buf, file_size_t size) {
+    if (!isWriteable())
+        OPDE_FILEEXCEPT(FILE_WRITE_ERROR, "Write on read-only file",
+                        "BufferedFile::write()");
+
+    mSrcFile->seek(static_cast<file_pos_t>(mFilePos));
+    mSrcFile->write(buf, size);
+
+    // the buffered data may be stale now
+    mBufLen = 0;
+
+    mFilePos += size;
+
+    if (mFilePos > mSize)
+        mSize = mFilePos;
+
+    return *this;
+}
+
+//------------------------------------
+bool BufferedFile::eof() const { return mFilePos >= mSize; }
+
+//------------------------------------
+FileSpan BufferedFile::readSpan(file_size_t size) {
+    if (mFilePos + size > mSize)
+        OPDE_FILEEXCEPT(FILE_READ_ERROR, "Read past end of file",
+                        "BufferedFile::readSpan()");
+
+    if (size == 0)
+        return FileSpan(NULL, 0);
+
+    if (size > mBuffer.size())
+        return File::readSpan(size);
+
+    if (buffered() < size)
+        fill();
+
+    const char *ptr = mBuffer.data() + (mFilePos - mBufPos);
+    mFilePos += size;
+
+    return FileSpan(ptr, size);
+}
 } // namespace Opde
@@ -32,11 +32,18 @@
 #include "SharedPtr.h"
 #include "integers.h"
 #include <fstream>
+#include <type_traits>
+#include <vector>
 
-// Maximal memory file buffer size. Reading/Writing structures bigger than this
-// will split those to fit into the buffers
+// Size of the temporary buffer used when copying data between files
 #define MEMORY_FILE_BUF_LEN 64000
 
+// Initial capacity of a MemoryFile's buffer
+#define MEMORY_FILE_MIN_CAPACITY 4096
+
+// Default read-ahead window of the BufferedFile
+#define BUFFERED_FILE_WINDOW (256 * 1024)
+
 namespace Opde {
 
 /** File error reasons. Will probably grow as needed */
@@ -80,6 +87,68 @@ public:
 #define OPDE_FILEEXCEPT(err, desc, src)                                        \
     throw(Opde::FileException(err, desc, src, __FILE__, __LINE__))
 
+/** Contiguous read only view of a part of a file, as returned by
+ * File::readSpan. Decodes little-endian data straight from memory, so whole
+ * structures can be parsed without a virtual read call per field.
+ * @note The span does not own the data. It is only valid until the next
+ * operation on the file it was acquired from */
+class FileSpan {
+public:
+    /** Constructor. Wraps size bytes starting at data */
+    FileSpan(const char *data, file_size_t size)
+        : mData(data), mSize(size), mPos(0){};
+
+    /** The first byte of the span */
+    const char *data() const { return mData; };
+
+    /** Size of the span in bytes */
+    file_size_t size() const { return mSize; };
+
+    /** Current read position, relative to the span's start */
+    file_size_t tell() const { return mPos; };
+
+    /** Count of the bytes not read yet */
+    file_size_t remaining() const { return mSize - mPos; };
+
+    /** returns true if the whole span was read */
+    bool eof() const { return mPos >= mSize; };
+
+    /** Returns a pointer to the next size bytes and skips them
+     * @throw FileException if the span has less than size bytes left */
+    const char *skip(file_size_t size);
+
+    /** Copies size bytes into the buffer provided */
+    FileSpan &read(void *buf, file_size_t size);
+
+    /** Reads an array of elementary types, swapping endianness on big-endian
+     * platforms. @see File::readElem */
+    FileSpan &readElem(void *buf, file_size_t size, uint count = 1);
+
+    /** Reads a single elementary (integer/float) value. Compound types
+     * provide their own free operator>> on FileSpan */
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value, FileSpan &>::type
+    operator>>(T &val) {
+        return readElem(&val, sizeof(T));
+    }
+
+protected:
+    const char *mData;
+    file_size_t mSize;
+    file_size_t mPos;
+};
+
+/** Describes whether a type can be read/written in bulk by
+ * File::read_vector and File::write_vector. Types which have enabled set to
+ * true have the very same memory layout as their little-endian file form
+ * (packed, no padding, trivially copyable) and provide a static
+ * swapEndian(T *data, file_size_t count) converting an array of them in place
+ * on big-endian platforms. Specialize for such types, preferably by
+ * inheriting FileBulkUniform. */
+template <typename T, typename Enable = void> struct FileBulkTraits {
+    static const bool enabled = false;
+};
+
 /** Abstract file access class. Provides data manipulation methods.
  * The class is exception based, that means, any error happening while
  * reading/writing will raise an exception.
@@ -175,14 +244,26 @@ public:
      */
     std::string getLine();
 
-    /** read properly sized vector of elements from File. 
-     * Expects propertly overloaded operator '>>' for type T on File&
+    /** Reads size bytes starting at the current position as one contiguous
+     * span, advancing the position past them. Memory backed files return
+     * their own storage, others read into an internal buffer.
+     * @return The span, valid until the next operation on this file
+     * @throw FileException if the read would reach past the end of file */
+    virtual FileSpan readSpan(file_size_t size);
+
+    /** Direct access to the whole contents of memory backed files
+     * @return Pointer to the first byte of the file, or NULL if the file is
+     * not memory backed. Valid until the next write to the file */
+    virtual const char *getData() const { return NULL; };
+
+    /** read properly sized vector of elements from File.
+     * Expects propertly overloaded operator '>>' for type T on File&, or
+     * FileBulkTraits<T> enabled - in which case the whole vector is read
+     * with a single read call.
     */
     template<typename T>
     void read_vector(std::vector<T> &target) {
-        for (auto &t: target) {
-            (*this) >> t;
-        }
+        _read_vector(target, std::integral_constant<bool, FileBulkTraits<T>::enabled>());
     }
 
     // resize vector to [count] elements, read vector of elements from File
@@ -192,25 +273,86 @@ public:
         read_vector(target);
     }
 
-    // read properly sized vector of elements from File
+    // write vector of elements to File. Bulk written if possible, see read_vector
     template<typename T>
     void write_vector(const std::vector<T> &target) {
-        for (const auto &t: target) {
-            (*this) << t;
-        }
+        _write_vector(target, std::integral_constant<bool, FileBulkTraits<T>::enabled>());
     }
 
-protected:
     /** swaps the endianness of the given buffer
      * @param ptr the buffer to swap endianness on
      * @param size the element size
      * @param count the count of swapped elements */
-    static void swapEndian(void *ptr, file_size_t size, uint count);
+    static void swapEndian(void *ptr, file_size_t size, file_size_t count);
+
+protected:
+    /// element by element vector read
+    template<typename T>
+    void _read_vector(std::vector<T> &target, std::false_type) {
+        for (auto &t: target) {
+            (*this) >> t;
+        }
+    }
+
+    /// bulk vector read
+    template<typename T>
+    void _read_vector(std::vector<T> &target, std::true_type) {
+        if (target.empty())
+            return;
+
+        read(target.data(), target.size() * sizeof(T));
+#ifdef __OPDE_BIG_ENDIAN
+        FileBulkTraits<T>::swapEndian(target.data(), target.size());
+#endif
+    }
+
+    /// element by element vector write
+    template<typename T>
+    void _write_vector(const std::vector<T> &target, std::false_type) {
+        for (const auto &t: target) {
+            (*this) << t;
+        }
+    }
+
+    /// bulk vector write
+    template<typename T>
+    void _write_vector(const std::vector<T> &target, std::true_type) {
+        if (target.empty())
+            return;
+
+#ifdef __OPDE_BIG_ENDIAN
+        std::vector<T> swapped(target);
+        FileBulkTraits<T>::swapEndian(swapped.data(), swapped.size());
+        write(swapped.data(), swapped.size() * sizeof(T));
+#else
+        write(target.data(), target.size() * sizeof(T));
+#endif
+    }
 
     std::string mFileName;
     unsigned mAccessMode;
+
+    /** Buffer backing the spans of files that can't expose their storage */
+    std::vector<char> mSpanBuffer;
+};
+
+/** Bulk trait base for types composed solely of ElemSize sized fields. The
+ * endianness is swapped as if the array was an array of ElemSize elements */
+template <typename T, file_size_t ElemSize> struct FileBulkUniform {
+    static const bool enabled = (sizeof(T) % ElemSize) == 0;
+
+    static void swapEndian(T *data, file_size_t count) {
+        File::swapEndian(data, ElemSize, count * (sizeof(T) / ElemSize));
+    }
 };
 
+/// Elementary types are bulk readable, except bool which is stored as 32 bit
+template <typename T>
+struct FileBulkTraits<
+    T, typename std::enable_if<std::is_arithmetic<T>::value &&
+                               !std::is_same<T, bool>::value>::type>
+    : public FileBulkUniform<T, sizeof(T)> {};
+
 // Stream - like bit shift operator overloads for common types
 File &operator<<(File &st, uint8_t val);
 File &operator<<(File &st, int8_t val);
@@ -322,17 +464,12 @@ public:
 
 /** Memory file. Virtual file existing in the memory. Speciality of this class
  * is an ability to write/read the data to/from another file instance.
- * Internally, the data are organized in buffers of maximal length of
- * MEMORY_FILE_BUF_LEN macro. */
+ * Internally, the data are kept in one contiguous buffer. */
 class MemoryFile : public File {
 protected:
-    /** File page vector (one Page contains data with length up to
-     * MEMORY_FILE_BUF_LEN) */
-    typedef std::vector<std::unique_ptr<char[]>> FilePages;
-
-    /** file pages
-     * File pages holding the file data */
-    FilePages mPages;
+    /** The file data. Contiguous, the capacity grows geometrically and
+     * only the first mSize bytes are valid */
+    std::vector<char> mData;
 
     /** Total file size */
     file_size_t mSize;
@@ -343,12 +480,8 @@ protected:
     /** EOF indicator */
     bool mEof;
 
-    /** Decompose the position to Buffer-number, relative buffer position
-     * @note Does validate against the file size
-     * @return std::pair<size_t, int> First is page index, second is relative
-     * position within page
-     */
-    std::pair<size_t, int> decomposePos(file_pos_t pos);
+    /** Ensures the buffer can hold at least size bytes */
+    void reserve(file_size_t size);
 
     /** Internal write. does not do read-only checks. */
     virtual File &_write(const void *buf, file_size_t size);
@@ -384,6 +517,16 @@ public:
     /** @copydoc File::eof() */
     virtual bool eof() const;
 
+    /** @copydoc File::readSpan() */
+    virtual FileSpan readSpan(file_size_t size);
+
+    /** @copydoc File::writeToFile()
+     * @note The buffer is handed to dest in a single write call */
+    virtual void writeToFile(File &dest);
+
+    /** @copydoc File::getData() */
+    virtual const char *getData() const { return mData.data(); };
+
     /** Initialize this file with the contents of another file
      * This method will read the specified quantum of bytes from the specified
      * stream.
@@ -457,6 +600,155 @@ private:
     /** eof indicator */
     bool mEof;
 };
+
+/** Read only memory mapped file. The whole file is mapped into the address
+ * space upon construction, so reading is a plain memory copy with no system
+ * call involved. A part of the mapping can be published as a file on it's own
+ * (a view), sharing the mapping with the parent file - no data are copied then.
+ * @note The mapping is released when the last file or view using it is
+ * destroyed */
+class MappedFile : public File {
+public:
+    /** Constructor. Maps the whole file named name in read only mode
+     * @throw Opde::FileException if the file cannot be opened or mapped */
+    MappedFile(const std::string &name);
+
+    /** View constructor. Publishes a part of the parent's mapping as a file.
+     * @param name The name of the view
+     * @param parent The mapped file the view is created upon
+     * @param pos The absolute position of the view in the parent file
+     * @param size The size of the view
+     * @throw Opde::FileException if the view would reach past parent's end */
+    MappedFile(const std::string &name, const MappedFile &parent,
+               file_pos_t pos, file_size_t size);
+
+    /** Destructor. Unmaps the file if no other view uses the mapping */
+    ~MappedFile();
+
+    /** @copydoc File::size() */
+    virtual const file_size_t size();
+
+    /** @copydoc File::seek(file_offset_t,SeekMode) */
+    virtual void seek(file_offset_t pos, SeekMode mode);
+
+    /** @copydoc File::seek(file_pos_t) */
+    virtual void seek(file_pos_t pos);
+
+    /** @copydoc File::tell() */
+    virtual const file_pos_t tell();
+
+    /** @copydoc File::read() */
+    virtual File &read(void *buf, file_size_t size);
+
+    /** @copydoc File::write() */
+    virtual File &write(const void *buf, file_size_t size);
+
+    /** @copydoc File::eof() */
+    virtual bool eof() const;
+
+    /** @copydoc File::readSpan() */
+    virtual FileSpan readSpan(file_size_t size);
+
+    /** @copydoc File::getData()
+     * @note For mapped files, the pointer is valid as long as the file
+     * exists */
+    virtual const char *getData() const { return mData; };
+
+protected:
+    /** OS level mapping holder. Shared between the file and all it's views */
+    class Mapping;
+
+    typedef shared_ptr<Mapping> MappingPtr;
+
+    /** The mapping this file reads from */
+    MappingPtr mMapping;
+
+    /** The first byte of this file in the mapping */
+    const char *mData;
+
+    /** Size of this file */
+    file_size_t mSize;
+
+    /** Absolute file position */
+    file_size_t mFilePos;
+
+    /** eof indicator */
+    bool mEof;
+};
+
+/// Shared pointer to memory mapped file
+typedef shared_ptr<MappedFile> MappedFilePtr;
+
+/** Read-ahead decorator for files with an expensive per-call read (StdFile,
+ * OgreFile). Reads from the source in windows of a configurable size and
+ * serves the small reads from memory. Seeking only moves the logical
+ * position, the source is repositioned on the next buffer refill.
+ * @note Writes are passed through to the source and invalidate the buffer.
+ * The source should not be used directly while wrapped */
+class BufferedFile : public File {
+public:
+    /** Constructor
+     * @param src The file to buffer. Reading starts at it's current position
+     * @param window The read-ahead window size in bytes */
+    BufferedFile(const FilePtr &src,
+                 file_size_t window = BUFFERED_FILE_WINDOW);
+
+    /** Destructor */
+    ~BufferedFile();
+
+    /** @copydoc File::size() */
+    virtual const file_size_t size();
+
+    /** @copydoc File::seek(file_offset_t,SeekMode) */
+    virtual void seek(file_offset_t pos, SeekMode mode);
+
+    /** @copydoc File::seek(file_pos_t) */
+    virtual void seek(file_pos_t pos);
+
+    /** @copydoc File::tell() */
+    virtual const file_pos_t tell();
+
+    /** @copydoc File::read() */
+    virtual File &read(void *buf, file_size_t size);
+
+    /** @copydoc File::write() */
+    virtual File &write(const void *buf, file_size_t size);
+
+    /** @copydoc File::eof() */
+    virtual bool eof() const;
+
+    /** @copydoc File::readSpan()
+     * @note Spans that fit into the window are served from the buffer */
+    virtual FileSpan readSpan(file_size_t size);
+
+    /** The buffered source file */
+    const FilePtr &getSource() const { return mSrcFile; };
+
+protected:
+    /** Refills the buffer with the window starting at the current position */
+    void fill();
+
+    /** Count of the buffered bytes available at the current position */
+    file_size_t buffered() const;
+
+    /** The source file */
+    FilePtr mSrcFile;
+
+    /** The read-ahead buffer */
+    std::vector<char> mBuffer;
+
+    /** Absolute position of the buffer's first byte in the source */
+    file_size_t mBufPos;
+
+    /** Count of the valid bytes in the buffer */
+    file_size_t mBufLen;
+
+    /** Source size */
+    file_size_t mSize;
+
+    /** Absolute (logical) file position */
+    file_size_t mFilePos;
+};
 } // namespace Opde
 
 #endif
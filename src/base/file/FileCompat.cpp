@@ -54,6 +54,11 @@ File &operator>>(File &st, Vector3 &val) {
     return st;
 }
 
+FileSpan &operator>>(FileSpan &st, Vector3 &val) {
+    st >> val.x >> val.y >> val.z;
+    return st;
+}
+
 // Plane
 File &operator<<(File &st, const Plane &val) {
     st << val.normal << val.d;
@@ -65,6 +70,11 @@ File &operator>>(File &st, Plane &val) {
     return st;
 }
 
+FileSpan &operator>>(FileSpan &st, Plane &val) {
+    st >> val.normal >> val.d;
+    return st;
+}
+
 File &operator<<(File &st, const Quaternion &val) {
     int16_t xi, yi, zi;
 
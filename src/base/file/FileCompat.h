@@ -43,14 +43,32 @@ File &operator>>(File &st, Vector2 &val);
 // Vector3
 File &operator<<(File &st, const Vector3 &val);
 File &operator>>(File &st, Vector3 &val);
+FileSpan &operator>>(FileSpan &st, Vector3 &val);
 
 // Plane
 File &operator<<(File &st, const Plane &val);
 File &operator>>(File &st, Plane &val);
+FileSpan &operator>>(FileSpan &st, Plane &val);
 
 // Quaternion
 File &operator<<(File &st, const Quaternion &val);
 File &operator>>(File &st, Quaternion &val);
+
+// Bulk vector I/O. Only if Ogre::Real is float, as the files are
+template <>
+struct FileBulkTraits<Vector2> : public FileBulkUniform<Vector2, sizeof(float)> {
+    static const bool enabled = sizeof(Vector2) == 2 * sizeof(float);
+};
+
+template <>
+struct FileBulkTraits<Vector3> : public FileBulkUniform<Vector3, sizeof(float)> {
+    static const bool enabled = sizeof(Vector3) == 3 * sizeof(float);
+};
+
+template <>
+struct FileBulkTraits<Plane> : public FileBulkUniform<Plane, sizeof(float)> {
+    static const bool enabled = sizeof(Plane) == 4 * sizeof(float);
+};
 } // namespace Opde
 
 #endif
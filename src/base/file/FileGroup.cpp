@@ -22,8 +22,12 @@
  *****************************************************************************/
 
 #include "FileGroup.h"
+#include "Parallel.h"
 #include "format.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace Opde {
 /*----------------------------------------------------*/
 /*-------------------- FileGroup ---------------------*/
@@ -46,7 +50,15 @@ std::string FileGroup::getName() {
 /*--------------------------------------------------------*/
 /*-------------------- DarkFileGroup ---------------------*/
 /*--------------------------------------------------------*/
-DarkFileGroup::DarkFileGroup(FilePtr &source) : FileGroup(source), mFiles() {
+DarkFileGroup::DarkFileGroup(FilePtr &source)
+    : FileGroup(source), mFiles(), mPrefetching(false), mPrefetchAbort(false) {
+    // Files that are not memory backed get a read-ahead buffer, as the
+    // chunks are parsed by many small reads
+    if (mSrcFile && !dynamic_cast<MappedFile *>(mSrcFile.get()) &&
+        !dynamic_cast<MemoryFile *>(mSrcFile.get()) &&
+        !dynamic_cast<BufferedFile *>(mSrcFile.get()))
+        mSrcFile = FilePtr(new BufferedFile(mSrcFile));
+
     if (mSrcFile) {
         // Read the header and stuff from the source file
         _initSource();
@@ -54,10 +66,13 @@ DarkFileGroup::DarkFileGroup(FilePtr &source) : FileGroup(source), mFiles() {
 }
 
 //------------------------------------
-DarkFileGroup::DarkFileGroup() : FileGroup() {}
+DarkFileGroup::DarkFileGroup()
+    : FileGroup(), mPrefetching(false), mPrefetchAbort(false) {}
 
 //------------------------------------
 DarkFileGroup::~DarkFileGroup() {
+    endPrefetch();
+
     // destroy all files in the map
     mFiles.clear();
 }
@@ -95,6 +110,9 @@ void DarkFileGroup::_initSource() {
     inventory.resize(chunkCount);
     for (auto &inv : inventory) *mSrcFile >> inv;
 
+    // Mapped sources get zero-copy views instead of seeking file parts
+    MappedFile *mapped = dynamic_cast<MappedFile *>(mSrcFile.get());
+
     // Init a file for all chunks given
     for (const auto &item : inventory) {
         Chunk ch;
@@ -107,27 +125,37 @@ void DarkFileGroup::_initSource() {
             OPDE_EXCEPT(format("Inventory chunk name mismatch: ",
                                ch.header.name, "-", item.name));
 
-        ch.file = FilePtr(new FilePart(
-            item.name, File::FILE_R, mSrcFile,
-            item.offset + sizeof(ch.header), item.length));
+        if (mapped)
+            ch.file = FilePtr(new MappedFile(item.name, *mapped,
+                                             item.offset + sizeof(ch.header),
+                                             item.length));
+        else
+            ch.file = FilePtr(new FilePart(
+                item.name, File::FILE_R, mSrcFile,
+                item.offset + sizeof(ch.header), item.length));
+
+        ch.offset = item.offset;
 
-        mFiles.insert(make_pair(std::string(item.name), ch));
+        mFiles.insert(std::string(item.name, strnlen(item.name, 12)), ch);
     }
 }
 
 //------------------------------------
 bool DarkFileGroup::hasFile(const std::string &name) const {
-    ChunkMap::const_iterator it = mFiles.find(name);
+    return mFiles.find(name) != NULL;
+}
 
-    return (it != mFiles.end());
+//------------------------------------
+bool DarkFileGroup::hasFile(const char *name, size_t len) const {
+    return mFiles.find(name, len) != NULL;
 }
 
 //------------------------------------
 const DarkDBChunkHeader &DarkFileGroup::getFileHeader(const std::string &name) {
-    ChunkMap::iterator it = mFiles.find(name);
+    ChunkMap::Entry *entry = mFiles.find(name);
 
-    if (it != mFiles.end())
-        return it->second.header;
+    if (entry)
+        return entry->second.header;
     else
         OPDE_FILEEXCEPT(
             FILE_OP_FAILED,
@@ -137,28 +165,36 @@ const DarkDBChunkHeader &DarkFileGroup::getFileHeader(const std::string &name) {
 
 //------------------------------------
 FilePtr DarkFileGroup::getFile(const std::string &name) {
-    std::string sname;
-    sname = name.substr(0, 11);
+    return getFile(name.data(), name.size());
+}
+
+//------------------------------------
+FilePtr DarkFileGroup::getFile(const char *name, size_t len) {
+    std::lock_guard<std::mutex> lock(mChunkMutex);
+
+    ChunkMap::Entry *entry = mFiles.find(name, len);
 
-    ChunkMap::iterator it = mFiles.find(sname);
+    if (entry) {
+        // the source is shared with the prefetch thread
+        if (mPrefetching)
+            loadChunk(entry->second);
 
-    if (it != mFiles.end()) {
-        it->second.file->seek(0);
-        return it->second.file;
+        entry->second.file->seek(0);
+        return entry->second.file;
     } else
-        OPDE_FILEEXCEPT(
-            FILE_OP_FAILED,
-            format("File named ", sname, " was not found in this FileGroup"),
-            "DarkFileGroup::getFile");
+        OPDE_FILEEXCEPT(FILE_OP_FAILED,
+                        format("File named ", std::string(name, len).substr(0, 11),
+                               " was not found in this FileGroup"),
+                        "DarkFileGroup::getFile");
 }
 
 //------------------------------------
 FilePtr DarkFileGroup::createFile(const std::string &name, uint32_t ver_maj,
                                   uint32_t ver_min) {
-    // look if the file map contained a file of that name before
-    ChunkMap::iterator it = mFiles.find(name);
+    std::lock_guard<std::mutex> lock(mChunkMutex);
 
-    if (it != mFiles.end()) {
+    // look if the file map contained a file of that name before
+    if (mFiles.find(name)) {
         OPDE_FILEEXCEPT(FILE_OTHER_ERROR,
                         format("Chunk already exists : " + name),
                         "DarkFileGroup::createFile");
@@ -169,6 +205,7 @@ FilePtr DarkFileGroup::createFile(const std::string &name, uint32_t ver_maj,
     ch.header.version_high = ver_maj;
     ch.header.version_low = ver_min;
     ch.header.zero = 0;
+    ch.offset = 0;
 
     // zero out the chunk name
     memset(ch.header.name, 0, 12);
@@ -178,75 +215,276 @@ FilePtr DarkFileGroup::createFile(const std::string &name, uint32_t ver_maj,
 
     ch.file = FilePtr(newfile);
 
-    mFiles.insert(make_pair(name, ch));
+    mFiles.insert(name, ch);
 
     return ch.file;
 }
 
 //------------------------------------
 void DarkFileGroup::deleteFile(const std::string &name) {
-    ChunkMap::iterator it = mFiles.find(name);
+    std::lock_guard<std::mutex> lock(mChunkMutex);
 
-    if (it != mFiles.end()) {
-        mFiles.erase(it);
-    } else {
+    if (!mFiles.erase(name)) {
         OPDE_EXCEPT(format("File requested for deletion was not found : ", name));
     }
 }
 
+//------------------------------------
+void DarkFileGroup::prefetch(const std::vector<std::string> &names) {
+    endPrefetch();
+
+    // the mapped chunks are independent views already. Any other source is
+    // shared by the chunk files, so those are handed out as copies
+    if (!mSrcFile || dynamic_cast<MappedFile *>(mSrcFile.get()))
+        return;
+
+    mPrefetching = true;
+    mPrefetchAbort = false;
+
+    mPrefetchThread =
+        std::thread(&DarkFileGroup::prefetchThread, this, names);
+}
+
+//------------------------------------
+void DarkFileGroup::endPrefetch() {
+    if (!mPrefetching)
+        return;
+
+    mPrefetchAbort = true;
+
+    if (mPrefetchThread.joinable())
+        mPrefetchThread.join();
+
+    mPrefetching = false;
+}
+
+//------------------------------------
+bool DarkFileGroup::isConcurrentReadSafe() {
+    return !mSrcFile || mPrefetching ||
+           dynamic_cast<MappedFile *>(mSrcFile.get());
+}
+
+//------------------------------------
+void DarkFileGroup::loadChunk(Chunk &chunk) {
+    FilePart *part = dynamic_cast<FilePart *>(chunk.file.get());
+
+    if (!part)
+        return;
+
+    MemoryFile *mf = new MemoryFile(part->getName(), File::FILE_R);
+    FilePtr loaded(mf);
+
+    part->seek(0);
+    mf->initFromFile(*part, part->size());
+
+    chunk.file = loaded;
+}
+
+//------------------------------------
+void DarkFileGroup::prefetchThread(std::vector<std::string> names) {
+    for (const auto &name : names) {
+        if (mPrefetchAbort)
+            break;
+
+        std::lock_guard<std::mutex> lock(mChunkMutex);
+
+        ChunkMap::Entry *entry = mFiles.find(name);
+
+        if (!entry)
+            continue;
+
+        try {
+            loadChunk(entry->second);
+        } catch (...) {
+            // nothing may escape the thread. Leave the chunk as it is - the read error will be reported to
+            // the consumer once it loads the chunk itself
+            break;
+        }
+    }
+}
+
 //------------------------------------
 void DarkFileGroup::write(FilePtr &dest) {
+    const file_size_t hdrSize = sizeof(DarkDBChunkHeader);
+
+    // the chunks are read directly below
+    endPrefetch();
+
     /*
-      First, calculate the inventory offset, it is:
-      Size of the main header. + size of all chunks (including the chunk header)
+      First, lay out the whole file. The chunks go right after the main
+      header, each with it's chunk header, in the map order. The inventory
+      follows the last chunk.
     */
+    std::vector<const Chunk *> chunks;
+    chunks.reserve(mFiles.size());
+
+    std::vector<DarkDBInvItem> inventory;
+    inventory.resize(mFiles.size());
 
     uint32_t inv_offset = sizeof(DarkDBHeader);
 
-    ChunkMap::const_iterator it = mFiles.begin();
+    size_t pos = 0;
+    for (auto it = mFiles.begin(); it != mFiles.end(); ++it, ++pos) {
+        chunks.push_back(&it->second);
 
-    uint32_t chunkcount = 0;
+        strncpy(inventory[pos].name, it->second.header.name, 12);
+        inventory[pos].offset = inv_offset;
+        inventory[pos].length = it->second.file->size();
 
-    for (; it != mFiles.end(); it++, chunkcount++) {
-        inv_offset += sizeof(DarkDBChunkHeader) + it->second.file->size();
+        inv_offset += hdrSize + inventory[pos].length;
     }
 
-    // Write the header
-    mHeader.inv_offset = inv_offset;
-    mHeader.zero = 0;
-    mHeader.one = 1;
+    // The image of the chunk area, assembled in memory
+    std::vector<char> image(inv_offset - sizeof(DarkDBHeader));
 
-    memset(&mHeader.zeros, 0, sizeof(mHeader.zeros));
+    // chunks which data can be copied without touching any shared file
+    std::vector<size_t> direct;
 
-    mHeader.dead_beef = 0x0EFBEADDE;
+    MemoryFile hdr("", File::FILE_RW);
+
+    for (pos = 0; pos < chunks.size(); ++pos) {
+        const Chunk &ch = *chunks[pos];
+        char *slot = image.data() + inventory[pos].offset - sizeof(DarkDBHeader);
+
+        // chunk header - encoded as in file
+        hdr.seek(0);
+        hdr << ch.header;
+        memcpy(slot, hdr.getData(), hdrSize);
+
+        // chunks read from the source share the source file - read serially
+        if (ch.file->getData() != NULL) {
+            direct.push_back(pos);
+        } else if (inventory[pos].length > 0) {
+            ch.file->seek(0);
+            ch.file->read(slot + hdrSize, inventory[pos].length);
+        }
+    }
 
-    // --- Let's write the header
-    mSrcFile->writeElem(&mHeader.inv_offset, 4);
-    mSrcFile->writeElem(&mHeader.zero, 4);
-    mSrcFile->writeElem(&mHeader.one, 4);
-    mSrcFile->write(&mHeader.zeros, 256);
-    mSrcFile->writeElem(&mHeader.dead_beef, 4);
+    // memory backed chunks are copied to their slots in parallel
+    parallelFor(direct.size(), [&](size_t idx) {
+        size_t cpos = direct[idx];
 
-    it = mFiles.begin();
+        memcpy(image.data() + inventory[cpos].offset - sizeof(DarkDBHeader) +
+                   hdrSize,
+               chunks[cpos]->file->getData(), inventory[cpos].length);
+    }, 16);
 
+    // --- Let's write the header, the chunks and the inventory
+    writeHeader(dest, inv_offset);
+
+    if (!image.empty())
+        dest->write(image.data(), image.size());
+
+    writeInventory(dest, inventory);
+}
+
+//------------------------------------
+file_size_t DarkFileGroup::writeIncremental(FilePtr &dest,
+                                            const DarkFileGroup &base) {
     std::vector<DarkDBInvItem> inventory;
-    inventory.resize(chunkcount);
+    inventory.resize(mFiles.size());
 
-    // Write the chunks
-    for (int pos = 0; it != mFiles.end(); it++, pos++) {
-        file_pos_t cfpos = dest->tell();
+    // chunks (with their inventory indices) that have to be appended
+    std::vector<std::pair<size_t, const Chunk *>> appended;
 
-        // write the chunk header
-        *dest << it->second.header;
+    // --- First pass: find out what stays in place. Nothing is written yet
+    size_t pos = 0;
+    for (auto it = mFiles.begin(); it != mFiles.end(); ++it, ++pos) {
+        const Chunk &ch = it->second;
 
-        // write the chunk data
-        it->second.file->writeToFile(*dest);
+        strncpy(inventory[pos].name, ch.header.name, 12);
+        inventory[pos].length = ch.file->size();
 
-        strncpy(inventory[pos].name, it->second.header.name, 12);
-        inventory[pos].offset = cfpos;
-        inventory[pos].length = it->second.file->size();
+        const ChunkMap::Entry *bentry = base.mFiles.find(it->first);
+
+        if (bentry && sameChunk(ch, bentry->second)) {
+            inventory[pos].offset = bentry->second.offset;
+        } else {
+            appended.push_back(std::make_pair(pos, &ch));
+        }
     }
 
+    // --- Second pass: append the changed chunks past the current end
+    file_size_t start = dest->size();
+    dest->seek(static_cast<file_pos_t>(start));
+
+    for (const auto &app : appended) {
+        inventory[app.first].offset = dest->tell();
+
+        *dest << app.second->header;
+        app.second->file->writeToFile(*dest);
+    }
+
+    // --- The new inventory goes last, then the header is switched to it
+    uint32_t inv_offset = dest->tell();
+    writeInventory(dest, inventory);
+
+    file_size_t end = dest->tell();
+
+    writeHeader(dest, inv_offset);
+
+    return end - start;
+}
+
+//------------------------------------
+bool DarkFileGroup::sameChunk(const Chunk &a, const Chunk &b) {
+    // only the chunks stored in the base file can stay in place
+    if (b.offset == 0)
+        return false;
+
+    if ((a.header.version_high != b.header.version_high) ||
+        (a.header.version_low != b.header.version_low))
+        return false;
+
+    file_size_t size = a.file->size();
+
+    if (size != b.file->size())
+        return false;
+
+    a.file->seek(0);
+    b.file->seek(0);
+
+    // compare window by window, the spans of both are valid at the same time
+    while (size > 0) {
+        file_size_t sz =
+            (size > MEMORY_FILE_BUF_LEN) ? MEMORY_FILE_BUF_LEN : size;
+
+        FileSpan sa = a.file->readSpan(sz);
+        FileSpan sb = b.file->readSpan(sz);
+
+        if (memcmp(sa.data(), sb.data(), sz) != 0)
+            return false;
+
+        size -= sz;
+    }
+
+    return true;
+}
+
+//------------------------------------
+void DarkFileGroup::writeHeader(FilePtr &dest, uint32_t inv_offset) {
+    mHeader.inv_offset = inv_offset;
+    mHeader.zero = 0;
+    mHeader.one = 1;
+
+    memset(&mHeader.zeros, 0, sizeof(mHeader.zeros));
+
+    mHeader.dead_beef = 0x0EFBEADDE;
+
+    dest->seek(0);
+
+    dest->writeElem(&mHeader.inv_offset, 4);
+    dest->writeElem(&mHeader.zero, 4);
+    dest->writeElem(&mHeader.one, 4);
+    dest->write(&mHeader.zeros, 256);
+    dest->writeElem(&mHeader.dead_beef, 4);
+}
+
+//------------------------------------
+void DarkFileGroup::writeInventory(
+    FilePtr &dest, const std::vector<DarkDBInvItem> &inventory) {
+    uint32_t chunkcount = inventory.size();
+
     // write the inventory size
     dest->writeElem(&chunkcount, sizeof(uint32_t));
 
@@ -262,4 +500,172 @@ FileGroup::const_iterator DarkFileGroup::begin() const {
 //------------------------------------
 FileGroup::const_iterator DarkFileGroup::end() const { return mFiles.end(); }
 
+/*----------------------------------------------------*/
+/*-------------- FileGroup::ChunkIndex ---------------*/
+/*----------------------------------------------------*/
+FileGroup::ChunkIndex::ChunkIndex() : mSlots(16, 0) {}
+
+//------------------------------------
+FileGroup::ChunkIndex::Key FileGroup::ChunkIndex::makeKey(const char *name,
+                                                          size_t len) {
+    Key key;
+
+    memset(key.name, 0, sizeof(key.name));
+
+    // only 11 characters are significant, as the 12th is the terminator
+    len = strnlen(name, std::min<size_t>(len, 11));
+    memcpy(key.name, name, len);
+
+    return key;
+}
+
+//------------------------------------
+uint32_t FileGroup::ChunkIndex::hash(const Key &key) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+
+    for (size_t i = 0; i < sizeof(key.name); ++i) {
+        h ^= static_cast<uint8_t>(key.name[i]);
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+//------------------------------------
+size_t FileGroup::ChunkIndex::findSlot(const Key &key) const {
+    size_t mask = mSlots.size() - 1;
+    size_t slot = hash(key) & mask;
+
+    // the load factor is kept at most 1/2, so an empty slot always exists
+    while (mSlots[slot] != 0) {
+        if (memcmp(mKeys[mSlots[slot] - 1].name, key.name, sizeof(key.name)) ==
+            0)
+            break;
+
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+//------------------------------------
+void FileGroup::ChunkIndex::rehash(size_t slots) {
+    mSlots.assign(slots, 0);
+
+    for (size_t idx = 0; idx < mKeys.size(); ++idx)
+        mSlots[findSlot(mKeys[idx])] = idx + 1;
+}
+
+//------------------------------------
+std::vector<uint32_t>::iterator
+FileGroup::ChunkIndex::orderPos(const Key &key) {
+    return std::lower_bound(mOrder.begin(), mOrder.end(), key,
+                            [this](uint32_t idx, const Key &k) {
+                                return memcmp(mKeys[idx].name, k.name,
+                                              sizeof(k.name)) < 0;
+                            });
+}
+
+//------------------------------------
+FileGroup::ChunkIndex::Entry *FileGroup::ChunkIndex::find(const char *name,
+                                                          size_t len) {
+    size_t slot = findSlot(makeKey(name, len));
+
+    return mSlots[slot] ? &mEntries[mSlots[slot] - 1] : NULL;
+}
+
+//------------------------------------
+const FileGroup::ChunkIndex::Entry *
+FileGroup::ChunkIndex::find(const char *name, size_t len) const {
+    size_t slot = findSlot(makeKey(name, len));
+
+    return mSlots[slot] ? &mEntries[mSlots[slot] - 1] : NULL;
+}
+
+//------------------------------------
+bool FileGroup::ChunkIndex::insert(const std::string &name,
+                                   const Chunk &chunk) {
+    Key key = makeKey(name.data(), name.size());
+
+    if (mSlots[findSlot(key)] != 0)
+        return false;
+
+    if ((mEntries.size() + 1) * 2 > mSlots.size())
+        rehash(mSlots.size() * 2);
+
+    uint32_t idx = mEntries.size();
+
+    mEntries.push_back(Entry(std::string(key.name), chunk));
+    mKeys.push_back(key);
+
+    mSlots[findSlot(key)] = idx + 1;
+    mOrder.insert(orderPos(key), idx);
+
+    return true;
+}
+
+//------------------------------------
+bool FileGroup::ChunkIndex::erase(const std::string &name) {
+    Key key = makeKey(name.data(), name.size());
+
+    size_t slot = findSlot(key);
+
+    if (mSlots[slot] == 0)
+        return false;
+
+    uint32_t idx = mSlots[slot] - 1;
+
+    // backward shift deletion - moves the following entries of the probe
+    // sequence to the freed slot if they may reside there
+    size_t mask = mSlots.size() - 1;
+    size_t next = slot;
+
+    for (;;) {
+        next = (next + 1) & mask;
+
+        if (mSlots[next] == 0)
+            break;
+
+        size_t home = hash(mKeys[mSlots[next] - 1]) & mask;
+
+        // is home cyclically outside (slot, next]?
+        bool movable = (slot <= next) ? ((home <= slot) || (home > next))
+                                      : ((home <= slot) && (home > next));
+
+        if (movable) {
+            mSlots[slot] = mSlots[next];
+            slot = next;
+        }
+    }
+
+    mSlots[slot] = 0;
+
+    mOrder.erase(orderPos(key));
+
+    // keep the entries dense - the last one takes the place of the erased
+    uint32_t last = mEntries.size() - 1;
+
+    if (idx != last) {
+        mEntries[idx] = mEntries[last];
+        mKeys[idx] = mKeys[last];
+
+        mSlots[findSlot(mKeys[idx])] = idx + 1;
+        *orderPos(mKeys[idx]) = idx;
+    }
+
+    mEntries.pop_back();
+    mKeys.pop_back();
+
+    return true;
+}
+
+//------------------------------------
+void FileGroup::ChunkIndex::clear() {
+    mEntries.clear();
+    mKeys.clear();
+    mOrder.clear();
+    mSlots.assign(16, 0);
+}
+
 } // namespace Opde
@@ -32,6 +32,13 @@
 #include "SharedPtr.h"
 #include "darkdb.h"
 
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
 namespace Opde {
 //------------------------ group of files
 /** File group stored inside a single file. This is an abstract class for file
@@ -54,6 +61,10 @@ public:
     /** Returns true if this file group contains the given file */
     virtual bool hasFile(const std::string &name) const = 0;
 
+    /** Returns true if this file group contains the given file. Lookup by a
+     * name that is not zero terminated, without constructing a string */
+    virtual bool hasFile(const char *name, size_t len) const = 0;
+
     /** Get stored file handle
      * @note This function does not return a clone to the file, rather always
      * the file itself. Usage at two places simultaneously will cause an
@@ -61,6 +72,10 @@ public:
      * @return Will return FilePtr seeked at the beginning of the file */
     virtual FilePtr getFile(const std::string &name) = 0;
 
+    /** Get stored file handle by a name that is not zero terminated
+     * @see getFile(const std::string&) */
+    virtual FilePtr getFile(const char *name, size_t len) = 0;
+
     /** Get the file header (Name, version info) */
     virtual const DarkDBChunkHeader &getFileHeader(const std::string &name) = 0;
 
@@ -81,6 +96,25 @@ public:
     standard writing is done into an empty file group */
     virtual void write(FilePtr &dest) = 0;
 
+    /** Starts loading the given chunks into memory on a background thread, in
+     * the given order, so the reads overlap with the parsing of the chunks
+     * requested before. Until endPrefetch is called, getFile hands out the
+     * chunks as in-memory files - a chunk that was not prefetched yet is
+     * loaded by the calling thread. getFile can be called from several
+     * threads meanwhile, each using a different chunk.
+     * @note The files obtained by getFile before the prefetch started must
+     * not be read until endPrefetch, as the source is read by the background
+     * thread meanwhile */
+    virtual void prefetch(const std::vector<std::string> &names) = 0;
+
+    /** Stops the prefetch started by prefetch, waiting for the background
+     * thread to finish. The chunks already loaded stay in memory */
+    virtual void endPrefetch() = 0;
+
+    /** Tells whether the files returned by getFile can be read by several
+     * threads at once, each thread reading a different file */
+    virtual bool isConcurrentReadSafe() = 0;
+
     /** Get the File name of this database, or empty string if no underlying
      * file is used */
     std::string getName();
@@ -89,11 +123,129 @@ public:
     struct Chunk {
         DarkDBChunkHeader header;
         FilePtr file;
+        /// Offset of the chunk in the source file, 0 if not loaded from it
+        uint32_t offset;
     };
 
-    typedef std::map<std::string, Chunk> ChunkMap;
+    /** Chunk index. Keyed by the fixed 12 byte chunk name (at most 11
+     * characters are significant, as in the file), hashed with open
+     * addressing. The chunks are stored densely and iterated ordered by
+     * name, so the iteration order does not depend on the insertion order.
+     */
+    class ChunkIndex {
+    public:
+        /// Name and chunk. The name is the truncated one
+        typedef std::pair<std::string, Chunk> Entry;
+
+        /// Iterates the entries ordered by name
+        class const_iterator {
+        public:
+            const_iterator(const ChunkIndex *index,
+                           std::vector<uint32_t>::const_iterator pos)
+                : mIndex(index), mPos(pos){};
+
+            const Entry &operator*() const { return mIndex->mEntries[*mPos]; };
+
+            const Entry *operator->() const {
+                return &mIndex->mEntries[*mPos];
+            };
+
+            const_iterator &operator++() {
+                ++mPos;
+                return *this;
+            };
+
+            const_iterator operator++(int) {
+                const_iterator prev(*this);
+                ++mPos;
+                return prev;
+            };
+
+            bool operator==(const const_iterator &b) const {
+                return mPos == b.mPos;
+            };
+
+            bool operator!=(const const_iterator &b) const {
+                return mPos != b.mPos;
+            };
+
+        private:
+            const ChunkIndex *mIndex;
+            std::vector<uint32_t>::const_iterator mPos;
+        };
+
+        ChunkIndex();
+
+        /** Finds the entry of the given name
+         * @return The entry or NULL if not found */
+        Entry *find(const char *name, size_t len);
+        const Entry *find(const char *name, size_t len) const;
+
+        Entry *find(const std::string &name) {
+            return find(name.data(), name.size());
+        };
+
+        const Entry *find(const std::string &name) const {
+            return find(name.data(), name.size());
+        };
+
+        /** Inserts a new chunk
+         * @return false if a chunk of that name already exists */
+        bool insert(const std::string &name, const Chunk &chunk);
+
+        /** Removes the chunk of the given name
+         * @return false if no such chunk exists */
+        bool erase(const std::string &name);
+
+        /// Removes all the chunks
+        void clear();
+
+        size_t size() const { return mEntries.size(); };
+
+        bool empty() const { return mEntries.empty(); };
+
+        const_iterator begin() const {
+            return const_iterator(this, mOrder.begin());
+        };
+
+        const_iterator end() const {
+            return const_iterator(this, mOrder.end());
+        };
+
+    private:
+        /// The fixed size key - zero padded chunk name
+        struct Key {
+            char name[12];
+        };
+
+        static Key makeKey(const char *name, size_t len);
+
+        static uint32_t hash(const Key &key);
+
+        /// Slot of the given key, or of the empty slot it would go to
+        size_t findSlot(const Key &key) const;
+
+        /// Rebuilds the hash table with the given slot count
+        void rehash(size_t slots);
+
+        /// Position of the entry with the given key in mOrder
+        std::vector<uint32_t>::iterator orderPos(const Key &key);
+
+        /// The entries, unordered
+        std::vector<Entry> mEntries;
+
+        /// Keys of the entries (same indices)
+        std::vector<Key> mKeys;
+
+        /// Hash table, entry index + 1 per slot, 0 if empty
+        std::vector<uint32_t> mSlots;
+
+        /// Entry indices ordered by the name
+        std::vector<uint32_t> mOrder;
+    };
+
+    typedef ChunkIndex ChunkMap;
 
-    typedef ChunkMap::iterator iterator;
     typedef ChunkMap::const_iterator const_iterator;
 
     /** Iterator's begin for file iteration */
@@ -129,15 +281,21 @@ public:
     /** @copydoc FileGroup::~FileGroup() */
     virtual ~DarkFileGroup();
 
-    /** @copydoc FileGroup::hasFile() */
+    /** @copydoc FileGroup::hasFile(const std::string&) const */
     virtual bool hasFile(const std::string &name) const;
 
+    /** @copydoc FileGroup::hasFile(const char*,size_t) const */
+    virtual bool hasFile(const char *name, size_t len) const;
+
     /** @copydoc FileGroup::getFileHeader() */
     virtual const DarkDBChunkHeader &getFileHeader(const std::string &name);
 
-    /** @copydoc FileGroup::getFile() */
+    /** @copydoc FileGroup::getFile(const std::string&) */
     virtual FilePtr getFile(const std::string &name);
 
+    /** @copydoc FileGroup::getFile(const char*,size_t) */
+    virtual FilePtr getFile(const char *name, size_t len);
+
     /** @copydoc FileGroup::createFile() */
     virtual FilePtr createFile(const std::string &name, uint32_t ver_maj,
                                uint32_t ver_min);
@@ -148,6 +306,32 @@ public:
     /** @copydoc FileGroup::write() */
     virtual void write(FilePtr &dest);
 
+    /** @copydoc FileGroup::prefetch()
+     * @note Does nothing if the source is a MappedFile. Then the chunk files
+     * are independent views of the mapped memory */
+    virtual void prefetch(const std::vector<std::string> &names);
+
+    /** @copydoc FileGroup::endPrefetch() */
+    virtual void endPrefetch();
+
+    /** @copydoc FileGroup::isConcurrentReadSafe()
+     * @note True for mapped sources, groups without source, and while
+     * prefetching. Otherwise the chunks share the position of the source */
+    virtual bool isConcurrentReadSafe();
+
+    /** Incremental (append-only) write. Updates a database file in place:
+     * the chunks that are the same as in the base (same version, size and
+     * contents) are left where they are, the others are appended at the end
+     * of dest, followed by a new inventory. The header is rewritten as the
+     * very last step, so an interrupted write leaves the old database intact.
+     * The chunks of base that are not present in this group become dead
+     * space - use write to compact the file.
+     * @param dest The file to update, opened for read and write. Has to
+     * contain the very same data as base's source
+     * @param base The group loaded from dest before the update
+     * @return The count of bytes appended to dest */
+    file_size_t writeIncremental(FilePtr &dest, const DarkFileGroup &base);
+
     /** @copydoc FileGroup::begin() */
     virtual const_iterator begin() const;
 
@@ -161,11 +345,42 @@ protected:
     */
     void _initSource();
 
+    /** Returns true if the chunk a can be replaced by the chunk b of the
+     * source file - same version, size and contents */
+    static bool sameChunk(const Chunk &a, const Chunk &b);
+
+    /** Writes the database header pointing to the inventory at inv_offset at
+     * the beginning of the dest file */
+    void writeHeader(FilePtr &dest, uint32_t inv_offset);
+
+    /** Writes the inventory at the current position of dest */
+    void writeInventory(FilePtr &dest,
+                        const std::vector<DarkDBInvItem> &inventory);
+
+    /** Replaces the chunk's file with an in-memory copy if it is a part of
+     * the source file. Has to be called with mChunkMutex held */
+    static void loadChunk(Chunk &chunk);
+
+    /** The background prefetch thread body */
+    void prefetchThread(std::vector<std::string> names);
+
     /** File (Chunk) map */
     ChunkMap mFiles;
 
     /** Source File header */
     DarkDBHeader mHeader;
+
+    /** Guards the chunk files and the source while prefetching */
+    std::mutex mChunkMutex;
+
+    /** The background thread loading the chunks */
+    std::thread mPrefetchThread;
+
+    /** Set while the prefetch is active */
+    bool mPrefetching;
+
+    /** Tells the prefetch thread to stop */
+    std::atomic<bool> mPrefetchAbort;
 };
 } // namespace Opde
 
@@ -89,6 +89,9 @@ void Logger::log(LogLevel level, const char *fmt, ...) {
     // to avoid losing headers on some lines
     std::string msg(result);
 
+    // keeps the lines of the message together
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
+
     std::string::iterator it = msg.begin();
 
     while (it != msg.end()) {
@@ -108,10 +111,12 @@ void Logger::log(LogLevel level, const char *fmt, ...) {
 }
 
 void Logger::registerLogListener(LogListener *listener) {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     mListeners.insert(listener);
 }
 
 void Logger::unregisterLogListener(LogListener *listener) {
+    std::lock_guard<std::recursive_mutex> lock(mMutex);
     mListeners.erase(listener);
 }
 
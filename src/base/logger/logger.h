@@ -28,6 +28,7 @@
 #include "config.h"
 
 #include "OpdeSingleton.h"
+#include <mutex>
 #include <set>
 #include <string>
 
@@ -37,7 +38,8 @@ class LogListener;
 
 /** Main logger class. This class is intended for logging purposes. Logging
  * listeners, registered using registerLogListener method recieve logging
- * messages formated by vsnprintf function */
+ * messages formated by vsnprintf function
+ * @note Logging is thread safe, the listeners are called one at a time */
 class Logger : public Singleton<Logger> {
 public:
     /// Logging level
@@ -55,6 +57,10 @@ private:
     /** A set of listener classes */
     LogListenerSet mListeners;
 
+    /** Serializes the dispatching, so the listeners receive the messages of
+     * the worker threads one at a time. Recursive, so a listener can log */
+    std::recursive_mutex mMutex;
+
     /** A global log level. Set by setLogLevel. All messages having higher log
      * level are ignored */
     LogLevel mLoggingLevel;
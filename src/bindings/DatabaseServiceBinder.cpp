@@ -148,14 +148,17 @@ const char *opde_DatabaseService_recursiveMergeLoad__doc__ =
     "@raise IOError: if something bad happened while loading";
 
 const char *opde_DatabaseService_save__doc__ =
-    "save(filename, mask)\n"
+    "save(filename, mask, incremental=False)\n"
     "Saves a tag database file of the especified type to a specified "
     "location.\n"
     "@type filename: string\n"
     "@type mask: integer\n"
+    "@type incremental: bool\n"
     "@param filename: The filename of the file to save\n"
     "@param mask: The mask to use while loading (see the DBM_ constants for "
     "more info)\n"
+    "@param incremental: If true, an existing database file is updated in "
+    "place, appending only the changed chunks\n"
     "@raise IOError: if something bad happened while loading";
 
 const char *opde_DatabaseService_unload__doc__ =
@@ -283,9 +286,10 @@ PyObject *DatabaseServiceBinder::save(PyObject *self, PyObject *args) {
 
     const char *fname;
     uint32_t mask;
+    int incremental = 0;
 
-    if (PyArg_ParseTuple(args, "si", &fname, &mask)) {
-        o->save(fname, mask);
+    if (PyArg_ParseTuple(args, "si|i", &fname, &mask, &incremental)) {
+        o->save(fname, mask, incremental != 0);
 
         __PY_NONE_RET;
     } else {
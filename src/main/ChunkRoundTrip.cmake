@@ -0,0 +1,48 @@
+# Round trip check of DarkFileGroup::write, run by ctest (chunk_roundtrip)
+#
+# Rewrites the database with "chunk -w" twice. The chunk listing of the
+# rewritten database has to match the listing of the original, and the second
+# rewrite has to be byte identical to the first one.
+#
+# Parameters:
+#   CHUNK    - the chunk executable
+#   DATABASE - the dark database to rewrite
+#   WORK_DIR - directory for the rewritten databases
+
+FILE(MAKE_DIRECTORY ${WORK_DIR})
+
+SET(FIRST ${WORK_DIR}/first.db)
+SET(SECOND ${WORK_DIR}/second.db)
+
+MACRO(RUN_CHUNK OUTVAR)
+    EXECUTE_PROCESS(COMMAND ${CHUNK} ${ARGN}
+        RESULT_VARIABLE _result
+        OUTPUT_VARIABLE ${OUTVAR}
+        ERROR_VARIABLE _error)
+
+    IF (NOT _result EQUAL 0)
+        MESSAGE(FATAL_ERROR "chunk ${ARGN} failed: ${_result} ${_error}")
+    ENDIF (NOT _result EQUAL 0)
+ENDMACRO(RUN_CHUNK)
+
+RUN_CHUNK(ORIG_LIST ${DATABASE})
+RUN_CHUNK(_dummy -w ${DATABASE} ${FIRST})
+RUN_CHUNK(FIRST_LIST ${FIRST})
+RUN_CHUNK(_dummy -w ${FIRST} ${SECOND})
+RUN_CHUNK(SECOND_LIST ${SECOND})
+
+IF (NOT ORIG_LIST)
+    MESSAGE(FATAL_ERROR "No chunks listed in ${DATABASE}")
+ENDIF (NOT ORIG_LIST)
+
+IF (NOT ORIG_LIST STREQUAL FIRST_LIST OR NOT ORIG_LIST STREQUAL SECOND_LIST)
+    MESSAGE(FATAL_ERROR "Chunk listings differ after the rewrite:\n"
+        "${ORIG_LIST}\n---\n${FIRST_LIST}\n---\n${SECOND_LIST}")
+ENDIF (NOT ORIG_LIST STREQUAL FIRST_LIST OR NOT ORIG_LIST STREQUAL SECOND_LIST)
+
+EXECUTE_PROCESS(COMMAND ${CMAKE_COMMAND} -E compare_files ${FIRST} ${SECOND}
+    RESULT_VARIABLE _result)
+
+IF (NOT _result EQUAL 0)
+    MESSAGE(FATAL_ERROR "Rewritten databases ${FIRST} and ${SECOND} differ")
+ENDIF (NOT _result EQUAL 0)
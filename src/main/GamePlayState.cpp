@@ -353,6 +353,9 @@ void GamePlayState::onLinkPlayerFactoryMsg(const LinkChangeMsg &msg) {
         // get the Link ref.
         const Link *l = mPlayerFactoryRelation->getLink(msg.linkID);
         StartingPointObjID = l->src();
+    } else if (msg.change == LNK_RELATION_LOADED && !msg.links->empty()) {
+        LOG_INFO("GamePlayState: Found StartingPoint");
+        StartingPointObjID = msg.links->back()->src();
     }
 }
 
@@ -33,12 +33,16 @@ void usage(const char *message = NULL) {
         std::cerr << message << std::endl;
 
     std::cout << "chunk FILE [CHUNK OUTFILE]" << std::endl
+              << "chunk -w FILE OUTFILE" << std::endl
               << "  FILE - the dark database file to read" << std::endl
               << "  CHUNK - the chunk name to extract" << std::endl
               << "  OUTFILE - the file that the chunk is written into"
               << std::endl
               << "  with just the first argument, the program lists the chunks "
                  "contained: CHUNK_NAME SIZE VERSION"
+              << std::endl
+              << "  -w rewrites the whole database into OUTFILE, as a save "
+                 "does"
               << std::endl;
 
     exit(1);
@@ -53,6 +57,22 @@ void listChunks(FileGroup &gr) {
     }
 }
 
+int rewrite(const char *from, const char *to) {
+    try {
+        FilePtr src = FilePtr(new MappedFile(from));
+        DarkFileGroup gr(src);
+
+        FilePtr dest = FilePtr(new StdFile(to, File::FILE_W));
+        gr.write(dest);
+    } catch (BasicException &e) {
+        std::cerr << "Exception occured trying to rewrite the database : "
+                  << e.getDetails() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     bool display = false; // only list the chunks
 
@@ -65,6 +85,13 @@ int main(int argc, char *argv[]) {
         usage();
     }
 
+    if (strcmp(argv[1], "-w") == 0) {
+        if (argc != 4)
+            usage("Rewrite needs the source and the output file");
+
+        return rewrite(argv[2], argv[3]);
+    }
+
     if (argc == 2) {
         display = true;
     } else if (argc == 3) {
@@ -72,7 +99,7 @@ int main(int argc, char *argv[]) {
     }
 
     try {
-        FilePtr src = FilePtr(new StdFile(argv[1], File::FILE_R));
+        FilePtr src = FilePtr(new MappedFile(argv[1]));
         DarkFileGroup gr (src);
 
         if (!display) {
@@ -87,9 +114,11 @@ int main(int argc, char *argv[]) {
     } catch (FileException &e) {
         std::cerr << "File exception occured trying to extract the chunk : "
                   << e.getDetails() << std::endl;
+        return 1;
     } catch (BasicException &e) {
         std::cerr << "Exception occured trying to extract the chunk : "
                   << e.getDetails() << std::endl;
+        return 1;
     }
 
     return 0;
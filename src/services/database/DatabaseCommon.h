@@ -4,6 +4,9 @@
 #include "DarkCommon.h"
 #include "integers.h"
 
+#include <string>
+#include <vector>
+
 namespace Opde {
 
 /// Database event types
@@ -155,6 +158,30 @@ protected:
     virtual void onDBLoad(const FileGroupPtr &db, uint32_t curmask) = 0;
     virtual void onDBSave(const FileGroupPtr &db, uint32_t tgtmask) = 0;
     virtual void onDBDrop(uint32_t dropmask) = 0;
+
+    /** Lists the chunks onDBLoad will read for the given mask, in the order
+     * they are read. The database service prefetches those in the background
+     * while the listeners before this one load. Optional - the chunks that are
+     * not listed are simply read on demand.
+     * @param curmask The mask onDBLoad will be called with
+     * @param chunks The chunk names to append to */
+    virtual void getDBLoadChunks(uint32_t curmask,
+                                 std::vector<std::string> &chunks){};
+
+    /** Tells whether onDBLoad may run on a worker thread, concurrently with
+     * the listeners it does not depend on. Such a listener may only touch its
+     * own data and the chunks it reads - no Ogre, no other services. */
+    virtual bool isDBLoadThreadSafe() { return false; };
+
+    /** Lists the priorities of the listeners that have to finish onDBLoad
+     * before onDBLoad of this listener starts. Only the lower priorities are
+     * considered.
+     * @param priorities The priorities to append to
+     * @return false to keep the default - wait for all the listeners
+     * registered before this one in the priority order */
+    virtual bool getDBLoadDependencies(std::vector<size_t> &priorities) {
+        return false;
+    };
 };
 
 } // namespace Opde
@@ -26,8 +26,16 @@
 #include "OgreTimer.h"
 #include "OpdeException.h"
 #include "OpdeServiceManager.h"
+#include "Parallel.h"
 #include "logger.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include <OgreArchive.h>
 #include <OgreResourceGroupManager.h>
 #include <OgreTimer.h>
 
@@ -128,11 +136,10 @@ void DatabaseService::mergeLoad(const std::string &filename,
 }
 
 //------------------------------------------------------
-void DatabaseService::save(const std::string &filename, uint32_t saveMask) {
+void DatabaseService::save(const std::string &filename, uint32_t saveMask,
+                           bool incremental) {
     // just prepare the progress and delegate to the broadcast
-    FilePtr fp = FilePtr(new StdFile(filename, File::FILE_RW));
-
-    FileGroupPtr tgtdb = FileGroupPtr(new DarkFileGroup());
+    shared_ptr<DarkFileGroup> tgtdb(new DarkFileGroup());
 
     LOG_DEBUG("DatabaseService::save - Save to file %s, mask %X",
               filename.c_str(), saveMask);
@@ -148,8 +155,31 @@ void DatabaseService::save(const std::string &filename, uint32_t saveMask) {
         1); // The version is fixed, really. Nothing to invent here
     fpf->writeElem(&saveMask, sizeof(uint32_t));
 
+    // The previous version of the file is the base of the incremental save
+    shared_ptr<DarkFileGroup> basedb;
+
+    if (incremental) {
+        try {
+            FilePtr bfp(new StdFile(filename, File::FILE_R));
+            basedb.reset(new DarkFileGroup(bfp));
+        } catch (const FileException &e) {
+            LOG_INFO("DatabaseService::save - No usable database to update "
+                     "in %s, doing a full save : %s",
+                     filename.c_str(), e.getDetails().c_str());
+        }
+    }
+
     // And Write!
-    tgtdb->write(fp);
+    if (basedb) {
+        FilePtr fp(new StdFile(filename, File::FILE_RW));
+        file_size_t appended = tgtdb->writeIncremental(fp, *basedb);
+
+        LOG_INFO("DatabaseService::save - Incremental save appended %zu bytes",
+                 appended);
+    } else {
+        FilePtr fp(new StdFile(filename, File::FILE_W));
+        tgtdb->write(fp);
+    }
 }
 
 //------------------------------------------------------
@@ -168,14 +198,54 @@ void DatabaseService::unload(uint32_t dropMask) {
 FileGroupPtr DatabaseService::getDBFileNamed(const std::string &filename) {
     // TODO: Group of of the resource through the configuration service, once
     // written
-    Ogre::DataStreamPtr stream =
-        Ogre::ResourceGroupManager::getSingleton().openResource(
-            filename, ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME);
-    FilePtr fp(new OgreFile(stream));
+    FilePtr fp = mapDBFileNamed(filename);
+
+    if (!fp) {
+        Ogre::DataStreamPtr stream =
+            Ogre::ResourceGroupManager::getSingleton().openResource(
+                filename, ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME);
+        fp = FilePtr(new OgreFile(stream));
+    }
 
     return FileGroupPtr(new DarkFileGroup(fp));
 }
 
+//------------------------------------------------------
+FilePtr DatabaseService::mapDBFileNamed(const std::string &filename) {
+    Ogre::ResourceGroupManager &rgm =
+        Ogre::ResourceGroupManager::getSingleton();
+
+    try {
+        const Ogre::String &group = rgm.findGroupContainingResource(filename);
+
+        Ogre::FileInfoListPtr fil = rgm.findResourceFileInfo(group, filename);
+
+        if (fil->empty())
+            return FilePtr();
+
+        const Ogre::FileInfo &fi = fil->front();
+
+        // only plain on-disk archives can be mapped. Compressed ones (crf)
+        // have to go through the stream
+        const Ogre::String &atype = fi.archive->getType();
+
+        if (atype != "FileSystem" && atype != "Dir")
+            return FilePtr();
+
+        std::string path = fi.archive->getName() + "/" + fi.filename;
+
+        return FilePtr(new MappedFile(path));
+    } catch (const FileException &e) {
+        LOG_DEBUG("DatabaseService::mapDBFileNamed - Could not map %s, "
+                  "falling back to stream: %s",
+                  filename.c_str(), e.getDetails().c_str());
+    } catch (const Ogre::Exception &) {
+        // not found by the resource system. The stream open will report
+    }
+
+    return FilePtr();
+}
+
 //------------------------------------------------------
 void DatabaseService::fineStep(int count) {
     // recalculate the status
@@ -274,28 +344,210 @@ std::string DatabaseService::loadFileNameFromTag(const Opde::FileGroupPtr &db,
 //------------------------------------------------------
 void DatabaseService::broadcastOnDBLoad(const FileGroupPtr &db,
                                         uint32_t curmask) {
+    // The chunks are streamed in the order the listeners will consume them
+    std::vector<std::string> chunks;
+
     Listeners::iterator it = mListeners.begin();
 
-    for (; it != mListeners.end(); ++it) {
-        unsigned long sttime = mTimer->getMilliseconds();
+    for (; it != mListeners.end(); ++it)
+        it->second->getDBLoadChunks(curmask, chunks);
 
-        // Inform about the load
-        it->second->onDBLoad(db, curmask);
+    LOG_DEBUG("DatabaseService: Prefetching %zu chunks of %s", chunks.size(),
+              db->getName().c_str());
 
-        unsigned long now = mTimer->getMilliseconds();
+    db->prefetch(chunks);
 
-        LOG_INFO("DatabaseService: Operation took %f seconds",
-                 (float)(now - sttime) / 1000);
+    // The load tasks, in the priority order. Each waits for it's dependencies
+    struct LoadTask {
+        DatabaseListener *listener;
+        bool threadSafe;
+        std::vector<size_t> deps;
+        int state; // 0 - waiting, 1 - running, 2 - finished
+    };
+
+    std::vector<LoadTask> tasks;
+    tasks.reserve(mListeners.size());
+
+    // no point in threads if there's just one core
+    bool concurrent = getWorkerCount() > 1;
+
+    for (it = mListeners.begin(); it != mListeners.end(); ++it) {
+        LoadTask task;
+
+        task.listener = it->second;
+        task.threadSafe = concurrent && it->second->isDBLoadThreadSafe();
+        task.state = 0;
+
+        std::vector<size_t> prios;
+        bool custom = it->second->getDBLoadDependencies(prios);
+
+        size_t idx = 0;
+
+        for (Listeners::iterator prev = mListeners.begin(); prev != it;
+             ++prev, ++idx) {
+            if (!custom || (prev->first < it->first &&
+                            std::find(prios.begin(), prios.end(),
+                                      prev->first) != prios.end()))
+                task.deps.push_back(idx);
+        }
+
+        tasks.push_back(task);
+    }
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::exception_ptr error;
+    std::vector<std::thread> workers;
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    size_t done = 0;
+
+    while (done < tasks.size()) {
+        // start all the ready thread safe tasks, and pick the first ready
+        // one of the others to run on this thread
+        LoadTask *ready = NULL;
+        bool started = false;
+
+        for (LoadTask &task : tasks) {
+            if (error)
+                break;
+
+            if (task.state != 0)
+                continue;
+
+            bool depsDone = true;
+
+            for (size_t dep : task.deps)
+                depsDone = depsDone && (tasks[dep].state == 2);
+
+            if (!depsDone)
+                continue;
+
+            if (task.threadSafe) {
+                LoadTask *worker = &task;
+
+                worker->state = 1;
+                started = true;
+
+                workers.push_back(std::thread([&, worker]() {
+                    std::exception_ptr err;
 
-        // recalculate the status
-        mLoadingStatus.currentCoarse++;
+                    try {
+                        callOnDBLoad(worker->listener, db, curmask);
+                    } catch (...) {
+                        err = std::current_exception();
+                    }
 
-        mLoadingStatus.recalc();
+                    std::lock_guard<std::mutex> wlock(mutex);
 
-        // call the progress listener if it is set
-        if (mProgressListener) {
-            (*mProgressListener)(mLoadingStatus);
+                    if (err && !error)
+                        error = err;
+
+                    worker->state = 2;
+                    finished.notify_all();
+                }));
+            } else if (!ready) {
+                ready = &task;
+            }
         }
+
+        if (ready) {
+            ready->state = 1;
+
+            lock.unlock();
+
+            std::exception_ptr err;
+
+            try {
+                callOnDBLoad(ready->listener, db, curmask);
+            } catch (...) {
+                err = std::current_exception();
+            }
+
+            lock.lock();
+
+            if (err && !error)
+                error = err;
+
+            ready->state = 2;
+
+            // the progress advances per listener, as with the serial load
+            lock.unlock();
+
+            coarseStep();
+            ++done;
+
+            lock.lock();
+            continue;
+        }
+
+        if (started)
+            continue;
+
+        // nothing to start - report the tasks finished by the workers (the
+        // ones run on this thread are reported already), or wait for some
+        size_t nowDone = 0;
+        size_t running = 0;
+
+        for (const LoadTask &task : tasks) {
+            nowDone += (task.state == 2) ? 1 : 0;
+            running += (task.state == 1) ? 1 : 0;
+        }
+
+        if (nowDone > done) {
+            // the progress listener is called from this thread only
+            lock.unlock();
+
+            for (; done < nowDone; ++done)
+                coarseStep();
+
+            lock.lock();
+            continue;
+        }
+
+        // failed, and the running tasks are over
+        if (error && running == 0)
+            break;
+
+        finished.wait(lock);
+    }
+
+    lock.unlock();
+
+    for (std::thread &worker : workers)
+        worker.join();
+
+    db->endPrefetch();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+//------------------------------------------------------
+void DatabaseService::callOnDBLoad(DatabaseListener *listener,
+                                   const FileGroupPtr &db, uint32_t curmask) {
+    unsigned long sttime = mTimer->getMilliseconds();
+
+    // Inform about the load
+    listener->onDBLoad(db, curmask);
+
+    unsigned long now = mTimer->getMilliseconds();
+
+    LOG_INFO("DatabaseService: Operation took %f seconds",
+             (float)(now - sttime) / 1000);
+}
+
+//------------------------------------------------------
+void DatabaseService::coarseStep() {
+    // recalculate the status
+    mLoadingStatus.currentCoarse++;
+
+    mLoadingStatus.recalc();
+
+    // call the progress listener if it is set
+    if (mProgressListener) {
+        (*mProgressListener)(mLoadingStatus);
     }
 }
 
@@ -315,15 +567,7 @@ void DatabaseService::broadcastOnDBSave(const FileGroupPtr &db,
         LOG_INFO("DatabaseService: Operation took %f seconds",
                  (float)(now - sttime) / 1000);
 
-        // recalculate the status
-        mLoadingStatus.currentCoarse++;
-
-        mLoadingStatus.recalc();
-
-        // call the progress listener if it is set
-        if (mProgressListener) {
-            (*mProgressListener)(mLoadingStatus);
-        }
+        coarseStep();
     }
 }
 
@@ -342,15 +586,7 @@ void DatabaseService::broadcastOnDBDrop(uint32_t dropmask) {
         LOG_INFO("DatabaseService: Operation took %f seconds",
                  (float)(now - sttime) / 1000);
 
-        // recalculate the status
-        mLoadingStatus.currentCoarse++;
-
-        mLoadingStatus.recalc();
-
-        // call the progress listener if it is set
-        if (mProgressListener) {
-            (*mProgressListener)(mLoadingStatus);
-        }
+        coarseStep();
     }
 }
 
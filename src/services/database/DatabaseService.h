@@ -61,8 +61,11 @@ public:
     /// Recursive load of all databases in hierarchy, without dropping
     void recursiveMergeLoad(const std::string &filename, uint32_t loadMask);
 
-    /// Saves a game database, writing all data fitting the specified mask
-    void save(const std::string &filename, uint32_t loadMask);
+    /** Saves a game database, writing all data fitting the specified mask
+     * @param incremental If true and the file already is a database, it is
+     * updated in place - only the changed chunks are appended to it */
+    void save(const std::string &filename, uint32_t loadMask,
+              bool incremental = false);
 
     /// Unload the game data. Release all the data fitting the mask specified
     void unload(uint32_t dropMask);
@@ -114,6 +117,12 @@ protected:
     /// Retrieve a readonly database file by it's name
     FileGroupPtr getDBFileNamed(const std::string &filename);
 
+    /** Tries to memory map the database file of the given name. Only works for
+     * files that reside in a plain directory archive.
+     * @return The mapped file or an empty pointer if the file can't be mapped
+     */
+    FilePtr mapDBFileNamed(const std::string &filename);
+
     /** Gets the database tag name containing the file name of the parent
      * database based on the FILE_TYPE value */
     const char *getParentDBTagName(uint32_t fileType);
@@ -122,9 +131,19 @@ protected:
     std::string loadFileNameFromTag(const FileGroupPtr &db,
                                     const char *tagname);
 
-    /// Calls onDBLoad on all listeners obeying priorities
+    /** Calls onDBLoad on all listeners obeying priorities. The chunks the
+     * listeners report by getDBLoadChunks are prefetched meanwhile. The thread
+     * safe listeners are run on worker threads as soon as the listeners they
+     * depend on finished, the others on the calling thread */
     void broadcastOnDBLoad(const FileGroupPtr &db, uint32_t curmask);
 
+    /** Calls onDBLoad of a single listener, logging the time it took */
+    void callOnDBLoad(DatabaseListener *listener, const FileGroupPtr &db,
+                      uint32_t curmask);
+
+    /** Advances the coarse loading status, informing the progress listener */
+    void coarseStep();
+
     /// Calls onDBLoad on all listeners obeying priorities
     void broadcastOnDBSave(const FileGroupPtr &db, uint32_t tgtmask);
 
@@ -24,6 +24,8 @@
 #include "CachedInheritor.h"
 #include "logger.h"
 
+#include <queue>
+
 using namespace std;
 
 namespace Opde {
@@ -32,7 +34,7 @@ namespace Opde {
 /*---------------------------------------------------------*/
 CachedInheritor::CachedInheritor(const InheritorFactory *fac,
                                  InheritService *is)
-    : Inheritor(fac), mInheritService(is) {
+    : Inheritor(fac), mInheritService(is), mBatchDepth(0) {
     InheritService::ListenerPtr callback(
         new ClassCallback<InheritChangeMsg, CachedInheritor>(
             this, &CachedInheritor::onInheritMsg));
@@ -80,91 +82,314 @@ bool CachedInheritor::unsetEffectiveID(int srcID) {
 
 //------------------------------------------------------
 bool CachedInheritor::refresh(int objID) {
-    // First, get the old effective ID
-    int oldEffID = getEffectiveID(objID);
+    if (mDirtySet.insert(objID).second)
+        mDirty.push_back(objID);
 
-    // Let's vote for a new effective object ID
-    InheritQueryResultPtr sources = mInheritService->getSources(objID);
+    if (mBatchDepth > 0)
+        return false;
 
-    int maxPrio = -1; // no inheritance indicator itself
-    int newEffID = 0; // Detected new effective ID
+    propagate();
+    return true;
+}
+
+//------------------------------------------------------
+/// Per object state of CachedInheritor::propagate
+struct PropagationNode {
+    PropagationNode() : pendingSources(0), needsVote(false) {}
+
+    /// Count of the sources (in the propagation) not processed yet
+    unsigned int pendingSources;
+    /// The object is dirty, or one of it's sources changed
+    bool needsVote;
+    /// The inheritance targets of the object
+    std::vector<int> targets;
+};
+
+//------------------------------------------------------
+/** Keeps the inheritor in a batch for the scope, so the refresh requests
+ * coming from the listeners are only collected. The depth is restored even
+ * if a listener throws */
+struct BatchScope {
+    BatchScope(unsigned int &depth) : mDepth(depth) { ++mDepth; }
+    ~BatchScope() { --mDepth; }
+
+    unsigned int &mDepth;
+};
+
+//------------------------------------------------------
+void CachedInheritor::propagate() {
+    BatchScope scope(mBatchDepth);
+
+    while (!mDirty.empty()) {
+        std::vector<int> dirty;
+        dirty.swap(mDirty);
+        mDirtySet.clear();
+
+        // A single request (the usual case outside of batches) has no other
+        // dirty objects to wait for. Plain worklist then, without the
+        // ordering overhead (a target reachable by more paths can get voted
+        // more than once)
+        if (dirty.size() == 1) {
+            while (!dirty.empty()) {
+                int objID = dirty.back();
+                dirty.pop_back();
+
+                if (!updateEffectiveID(objID, vote(objID)))
+                    continue;
+
+                InheritQueryResultPtr targets =
+                    mInheritService->getTargets(objID);
+
+                while (!targets->end())
+                    dirty.push_back(targets->next().dstID);
+            }
+
+            continue;
+        }
+
+        typedef std::unordered_map<int, PropagationNode> Nodes;
+        Nodes nodes;
+
+        // The dirty objects, and everything inheriting from them
+        std::vector<int> pending(dirty);
+
+        while (!pending.empty()) {
+            int objID = pending.back();
+            pending.pop_back();
+
+            std::pair<Nodes::iterator, bool> r =
+                nodes.emplace(objID, PropagationNode());
+
+            if (!r.second)
+                continue;
+
+            InheritQueryResultPtr targets = mInheritService->getTargets(objID);
+
+            while (!targets->end()) {
+                int dstID = targets->next().dstID;
+
+                r.first->second.targets.push_back(dstID);
+                pending.push_back(dstID);
+            }
+        }
 
-    int niter = 0;
+        for (int objID : dirty)
+            nodes[objID].needsVote = true;
 
+        for (auto &node : nodes) {
+            for (int dstID : node.second.targets)
+                ++nodes[dstID].pendingSources;
+        }
+
+        // Worklist of the objects having all the sources final. This gives
+        // the topological order - each object is voted once
+        for (auto &node : nodes) {
+            if (node.second.pendingSources == 0)
+                pending.push_back(node.first);
+        }
+
+        size_t processed = 0;
+
+        while (!pending.empty()) {
+            int objID = pending.back();
+            pending.pop_back();
+            ++processed;
+
+            PropagationNode &node = nodes[objID];
+
+            bool changed =
+                node.needsVote && updateEffectiveID(objID, vote(objID));
+
+            for (int dstID : node.targets) {
+                PropagationNode &target = nodes[dstID];
+
+                // no change, no need to vote on the targets
+                target.needsVote = target.needsVote || changed;
+
+                if (--target.pendingSources == 0)
+                    pending.push_back(dstID);
+            }
+        }
+
+        // Only happens with inheritance cycles. Vote the rest in any order
+        if (processed != nodes.size()) {
+            LOG_ERROR("CachedInheritor: Inheritance cycle detected, %zu "
+                      "objects refreshed out of order",
+                      nodes.size() - processed);
+
+            for (auto &node : nodes) {
+                if (node.second.pendingSources > 0)
+                    updateEffectiveID(node.first, vote(node.first));
+            }
+        }
+    }
+}
+
+//------------------------------------------------------
+int CachedInheritor::vote(int objID) const {
     // If self-implements
     if (getImplements(objID)) {
         // self, because prop on object masks any inherited prop, be it mp or
         // archetype
-        newEffID = objID;
-    } else {
-        // does not self-implement...
-        // now for each of the sources, find the one with the max. priority that
-        // still implements. Some logic to accept the self assigned is also
-        // present
-        while (!sources->end()) {
-            const InheritLink &il = sources->next();
-            ++niter;
-
-            // look for the effective ID of the source
-            int effID = getEffectiveID(il.srcID);
-
-            /*
-            validate and compare to the maximal. If priority is greater,
-            we have a new winner (but only if it validates and the source has
-            some effective ID)
-            */
-            // Comparing the priority to signed int...
-            if (validate(il.srcID, il.dstID, il.priority) &&
-                (il.priority > maxPrio) && (effID != 0)) {
-                maxPrio = il.priority;
-                newEffID = effID;
-            }
+        return objID;
+    }
+
+    int maxPrio = -1; // no inheritance indicator itself
+    int newEffID = 0; // Detected new effective ID
+
+    // does not self-implement...
+    // now for each of the sources, find the one with the max. priority that
+    // still implements. Some logic to accept the self assigned is also
+    // present
+    InheritQueryResultPtr sources = mInheritService->getSources(objID);
+
+    while (!sources->end()) {
+        const InheritLink &il = sources->next();
+
+        // look for the effective ID of the source
+        int effID = getEffectiveID(il.srcID);
+
+        /*
+        validate and compare to the maximal. If priority is greater,
+        we have a new winner (but only if it validates and the source has
+        some effective ID)
+        */
+        // Comparing the priority to signed int...
+        if (validate(il.srcID, il.dstID, il.priority) &&
+            (il.priority > maxPrio) && (effID != 0)) {
+            maxPrio = il.priority;
+            newEffID = effID;
         }
     }
 
-    if (newEffID != 0) {
-        if (setEffectiveID(objID, newEffID)) {
-            // Broadcast the change to a new ID
-            InheritValueChangeMsg msg;
-
-            if (oldEffID != 0) {
-                msg.change = INH_VAL_CHANGED;
-            } else {
-                msg.change = INH_VAL_ADDED;
-            }
+    return newEffID;
+}
+
+//------------------------------------------------------
+bool CachedInheritor::updateEffectiveID(int objID, int newEffID) {
+    // First, get the old effective ID
+    int oldEffID = getEffectiveID(objID);
 
-            msg.objectID = objID;
-            msg.srcID = newEffID;
+    if (storeEffectiveID(objID, newEffID))
+        broadcastChange(objID, oldEffID, newEffID);
 
-            LOG_VERBOSE(
-                "Inheritance change happened on %d (new src %d, old src %d)",
-                objID, newEffID, oldEffID);
-            broadcastMessage(msg);
+    return newEffID != oldEffID;
+}
+
+//------------------------------------------------------
+bool CachedInheritor::storeEffectiveID(int objID, int newEffID) {
+    if (newEffID != 0)
+        return setEffectiveID(objID, newEffID);
+
+    return unsetEffectiveID(objID);
+}
+
+//------------------------------------------------------
+void CachedInheritor::broadcastChange(int objID, int oldEffID, int newEffID) {
+    InheritValueChangeMsg msg;
+
+    msg.objectID = objID;
+    msg.srcID = newEffID;
+
+    if (newEffID != 0) {
+        // Broadcast the change to a new ID
+        if (oldEffID != 0) {
+            msg.change = INH_VAL_CHANGED;
+        } else {
+            msg.change = INH_VAL_ADDED;
         }
-    } else if (unsetEffectiveID(objID)) {
-        InheritValueChangeMsg msg;
 
+        LOG_VERBOSE(
+            "Inheritance change happened on %d (new src %d, old src %d)",
+            objID, newEffID, oldEffID);
+    } else {
         msg.change = INH_VAL_REMOVED;
 
-        msg.objectID = objID;
-        msg.srcID = 0;
-
         LOG_VERBOSE("Inheritance removal happened on %d (old src %d)", objID,
                     oldEffID);
-        broadcastMessage(msg);
     }
 
-    // If there was a change, propagate
-    if (newEffID != oldEffID) {
-        InheritQueryResultPtr targets = mInheritService->getTargets(objID);
+    broadcastMessage(msg);
+}
 
-        while (!targets->end()) {
-            const InheritLink &il = targets->next();
+//------------------------------------------------------
+void CachedInheritor::beginBatch() { ++mBatchDepth; }
 
-            refresh(il.dstID); // refresh the target object
-        }
+//------------------------------------------------------
+void CachedInheritor::endBatch() {
+    assert(mBatchDepth > 0);
+
+    if (--mBatchDepth > 0)
+        return;
+
+    if (!mResolved.empty()) {
+        std::vector<ResolvedChange> resolved;
+        resolved.swap(mResolved);
+
+        BatchScope scope(mBatchDepth);
+
+        for (const ResolvedChange &rc : resolved)
+            broadcastChange(rc.objID, rc.oldEffID, getEffectiveID(rc.objID));
+    }
+
+    propagate();
+}
+
+//------------------------------------------------------
+/// Min-heap order of the resolveBatch queue - lower rank first
+struct RankGreater {
+    bool operator()(const std::pair<unsigned int, int> &a,
+                    const std::pair<unsigned int, int> &b) const {
+        return a.first > b.first;
+    }
+};
+
+//------------------------------------------------------
+void CachedInheritor::resolveBatch(const InheritOrder &order) {
+    // only the outermost batch is resolved
+    if (mBatchDepth != 1 || mDirty.empty())
+        return;
+
+    typedef std::pair<unsigned int, int> QueueItem;
+
+    std::priority_queue<QueueItem, std::vector<QueueItem>, RankGreater> queue;
+
+    // Objects queued so far. Every object is queued (and voted) once - the
+    // targets rank higher than their sources, so no source is voted after
+    // it's targets
+    std::unordered_set<int> queued;
+
+    auto enqueue = [&](int objID) {
+        if (!queued.insert(objID).second)
+            return;
+
+        InheritOrder::const_iterator it = order.find(objID);
+        queue.push(QueueItem(it != order.end() ? it->second : 0, objID));
+    };
+
+    for (int objID : mDirty)
+        enqueue(objID);
+
+    mDirty.clear();
+    mDirtySet.clear();
+
+    while (!queue.empty()) {
+        int objID = queue.top().second;
+        queue.pop();
+
+        int oldEffID = getEffectiveID(objID);
+
+        if (!storeEffectiveID(objID, vote(objID)))
+            continue;
+
+        ResolvedChange rc = {objID, oldEffID};
+        mResolved.push_back(rc);
+
+        InheritQueryResultPtr targets = mInheritService->getTargets(objID);
+
+        while (!targets->end())
+            enqueue(targets->next().dstID);
     }
-    return false;
 }
 
 //------------------------------------------------------
@@ -195,6 +420,9 @@ void CachedInheritor::grow(int minID, int maxID) {
 void CachedInheritor::clear() {
     mEffObjMap.clear();
     mImplements.clear();
+    mDirty.clear();
+    mDirtySet.clear();
+    mResolved.clear();
 }
 
 //------------------------------------------------------
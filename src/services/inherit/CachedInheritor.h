@@ -28,6 +28,9 @@
 #include "BitArray.h"
 #include "InheritService.h"
 
+#include <unordered_set>
+#include <vector>
+
 namespace Opde {
 /** Base class for cached inheritor implementations. Works self as "always"
  * inheritor, inheriting in every situation. This class implements all methods
@@ -62,6 +65,18 @@ public:
 
     void grow(int minID, int maxID);
 
+    /// @see Inheritor::beginBatch
+    virtual void beginBatch();
+
+    /// @see Inheritor::endBatch
+    virtual void endBatch();
+
+    /** Votes the dirty objects and the targets of the changed ones in the
+     * given order, storing the changes without broadcasting. The changes are
+     * broadcasted in endBatch
+     * @see Inheritor::resolveBatch */
+    virtual void resolveBatch(const InheritOrder &order);
+
 protected:
     /** Sets new cached effective ID for the given object
      * @param srcID the object to set effective ID for
@@ -76,25 +91,47 @@ protected:
      * @return True if a change happened */
     virtual bool unsetEffectiveID(int srcID);
 
-    /** Propagates new Effective source, recursively, on all inheritor targets.
+    /** Requests the refresh of the effective ID of the object, and of all
+     * it's inheritance targets if it changes. Outside of a batch, the
+     * propagation happens immediately, otherwise in endBatch.
      *
-     * This method changes the records in Effective object cache. For each
-     * object, a list of the sources is queried. Then:
-     * @li A vote for new effective object is done (highest priority), querying
-     * parent objects for thei're effective ID's. That ID is then recursively
-     * propagated, but only if a change happened to the effective ID of the
-     * Object.
+     * For each object, a vote for new effective object is done (highest
+     * priority), querying parent objects for thei're effective ID's.
      *
      * @param objID the source of the propagation (a parent object ID)
-     *
-     * @note The propagation stops (won't recurse) when:
-     * @li The propagated effective ID encounters an object where the srcID
-     * propagation is masked ineffective
-     * @li No targets are found to propagate to
-     * @li No change hapened to the object's effective ID
+     * @return true if the propagation happened (false if deferred)
+     * @see propagate
      */
     virtual bool refresh(int objID);
 
+    /** Propagates the effective ID changes of the dirty objects. Collects the
+     * dirty objects with all their inheritance targets, then processes them
+     * in the topological order of the inheritance graph (sources before
+     * targets) with an explicit worklist. This way each object is voted once,
+     * after all it's sources are final, and a single InheritValueChangeMsg is
+     * broadcasted per changed object.
+     *
+     * @note Only the dirty objects and the targets of the changed objects are
+     * voted
+     */
+    void propagate();
+
+    /** Votes for the effective ID of the object, from the effective IDs of
+     * it's sources
+     * @return The new effective ID, 0 if none */
+    int vote(int objID) const;
+
+    /** Stores the new effective ID, broadcasting the change
+     * @return true if the effective ID changed */
+    bool updateEffectiveID(int objID, int newEffID);
+
+    /** Stores the new effective ID without broadcasting
+     * @return true if the stored effective ID changed */
+    bool storeEffectiveID(int objID, int newEffID);
+
+    /// Broadcasts the change of the effective ID of the object
+    void broadcastChange(int objID, int oldEffID, int newEffID);
+
     /// @see Inheritor::valueChanged
     void valueChanged(int objID, const std::string &field,
                       const Variant &value);
@@ -116,6 +153,24 @@ protected:
     typedef BitArray ImplementsMap;
 
     ImplementsMap mImplements;
+
+    /// Nesting depth of beginBatch calls
+    unsigned int mBatchDepth;
+
+    /// Objects waiting for the refresh, in the order of the requests
+    std::vector<int> mDirty;
+
+    /// The set of mDirty, to keep it unique
+    std::unordered_set<int> mDirtySet;
+
+    /// A change stored by resolveBatch, waiting for the broadcast
+    struct ResolvedChange {
+        int objID;
+        int oldEffID;
+    };
+
+    /// Changes stored by resolveBatch, in the resolution order
+    std::vector<ResolvedChange> mResolved;
 };
 
 /** Cached inheritor factory. The inheritor produced is named "always" and will,
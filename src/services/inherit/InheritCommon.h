@@ -34,6 +34,8 @@
 #include "SharedPtr.h"
 #include "Variant.h"
 
+#include <unordered_map>
+
 namespace Opde {
 // Forward declaration
 class InheritService;
@@ -81,6 +83,11 @@ struct InheritValueChangeMsg {
     Variant value;
 };
 
+/** Topological order of the inheritance graph - the rank of each linked
+ * object, sources ranked lower than their targets. Objects without any
+ * inheritance links are not present (their rank is 0) */
+typedef std::unordered_map<int, unsigned int> InheritOrder;
+
 // forward decl.
 class InheritorFactory;
 
@@ -148,6 +155,22 @@ public:
     /// about defined object range
     virtual void grow(int minID, int maxID){/**/};
 
+    /** Starts a batch of changes. Until the matching endBatch, the inheritor
+     * may only collect the objects to refresh, and refresh them all at once
+     * in endBatch. Batches nest. @see InheritService::beginBatch */
+    virtual void beginBatch(){/**/};
+
+    /// Ends the batch of changes. @see beginBatch
+    virtual void endBatch(){/**/};
+
+    /** Resolves the changes collected in the outermost batch, right before
+     * it's endBatch. Called concurrently for all the inheritors, while the
+     * inheritance graph is frozen - so it may only read the graph and touch
+     * the inheritor's own state. No messages may be broadcasted here, these
+     * are deferred to endBatch
+     * @param order The topological order of the inheritance graph */
+    virtual void resolveBatch(const InheritOrder &order){/**/};
+
     /// on a value change, the inheritor propagates the field and the new value
     /// to all affected objects
     virtual void valueChanged(int objID, const std::string &field,
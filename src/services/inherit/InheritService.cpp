@@ -27,6 +27,7 @@
 #include "CachedInheritor.h"
 #include "NeverInheritor.h"
 #include "OpdeServiceManager.h"
+#include "Parallel.h"
 #include "ServiceCommon.h"
 #include "SingleFieldDataStorage.h"
 #include "format.h"
@@ -34,6 +35,9 @@
 #include "link/Relation.h"
 #include "logger.h"
 
+#include <chrono>
+#include <exception>
+
 using namespace std;
 
 namespace Opde {
@@ -85,7 +89,7 @@ const size_t ServiceImpl<InheritService>::SID = __SERVICE_ID_INHERIT;
 
 InheritService::InheritService(ServiceManager *manager, const std::string &name)
     : ServiceImpl<Opde::InheritService>(manager, name), mMetaPropListenerID(0),
-      mMetaPropRelation() {
+      mMetaPropRelation(), mBatchDepth(0) {
     // Register some common factories.
     // If a special factory would be needed, it has to be registered prior to
     // it's usage, okay?
@@ -126,6 +130,11 @@ Inheritor *InheritService::createInheritor(const std::string &name) {
     if (it != mInheritorFactoryMap.end()) {
         Inheritor *inh = it->second->createInstance(this);
         mInheritors.push_back(inh); // no need map by name
+
+        // joins the running batch
+        for (unsigned int i = 0; i < mBatchDepth; ++i)
+            inh->beginBatch();
+
         return inh;
     } else
         OPDE_EXCEPT(format("No inheritor factory found for name : ", name));
@@ -195,6 +204,33 @@ void InheritService::onMetaPropMsg(const LinkChangeMsg &msg) {
         return;
     }
 
+    // Bulk load. Insert all the links first, then inform the inheritors,
+    // which refresh once for the whole batch
+    if (msg.change == LNK_RELATION_LOADED) {
+        assert(msg.links);
+
+        InheritBatch batch(this);
+
+        // the priority field, resolved once for the whole batch
+        FieldHandle prio = mMetaPropRelation->getFieldHandle("");
+
+        for (const Link *l : *msg.links)
+            _addLink(*l,
+                     mMetaPropRelation->getLinkField(l->id(), prio).toUInt());
+
+        InheritChangeMsg smsg;
+        smsg.change = INH_ADDED;
+
+        for (const Link *l : *msg.links) {
+            smsg.srcID = l->dst();
+            smsg.dstID = l->src();
+            broadcastMessage(smsg);
+        }
+
+        batch.end();
+        return;
+    }
+
     // Read the link source, destination and priority
 
     // Get the priority of the link
@@ -259,6 +295,140 @@ void InheritService::grow(int minID, int maxID) {
     }
 }
 
+//------------------------------------------------------
+void InheritService::beginBatch() {
+    ++mBatchDepth;
+
+    for (Inheritor *inh : mInheritors)
+        inh->beginBatch();
+}
+
+//------------------------------------------------------
+void InheritService::endBatch() {
+    assert(mBatchDepth > 0);
+
+    --mBatchDepth;
+
+    // A failure must not leave the batch open, the inheritors would only
+    // collect the changes from then on
+    std::exception_ptr error;
+
+    // The graph does not change until the inheritors broadcast in endBatch
+    if (mBatchDepth == 0) {
+        try {
+            resolveBatch();
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+
+    for (Inheritor *inh : mInheritors) {
+        try {
+            inh->endBatch();
+        } catch (...) {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+//------------------------------------------------------
+void InheritService::buildOrder(InheritOrder &order) const {
+    order.clear();
+
+    // count of the sources not ranked yet, per linked object
+    std::unordered_map<int, size_t> pending;
+    pending.reserve(mInheritSources.size() + mInheritTargets.size());
+
+    for (const auto &src : mInheritSources)
+        pending[src.first] = src.second.size();
+
+    for (const auto &tgt : mInheritTargets)
+        pending.emplace(tgt.first, 0);
+
+    order.reserve(pending.size());
+
+    std::vector<int> ready;
+
+    for (const auto &node : pending) {
+        if (node.second == 0)
+            ready.push_back(node.first);
+    }
+
+    unsigned int rank = 0;
+
+    while (!ready.empty()) {
+        int objID = ready.back();
+        ready.pop_back();
+
+        order[objID] = ++rank;
+
+        InheritMap::const_iterator it = mInheritTargets.find(objID);
+
+        if (it == mInheritTargets.end())
+            continue;
+
+        for (const auto &tgt : it->second) {
+            if (--pending[tgt.first] == 0)
+                ready.push_back(tgt.first);
+        }
+    }
+
+    if (order.size() == pending.size())
+        return;
+
+    LOG_ERROR("InheritService: Inheritance cycle detected, %zu objects are "
+              "ordered arbitrarily",
+              pending.size() - order.size());
+
+    for (const auto &node : pending) {
+        if (node.second > 0)
+            order[node.first] = ++rank;
+    }
+}
+
+//------------------------------------------------------
+void InheritService::resolveBatch() {
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point start = Clock::now();
+
+    // computed once, shared by all the inheritors
+    InheritOrder order;
+    buildOrder(order);
+
+    Clock::time_point ordered = Clock::now();
+
+    // time spent per inheritor, the sum is the serial cost
+    std::vector<double> spent(mInheritors.size(), 0);
+
+    parallelFor(mInheritors.size(), [&](size_t idx) {
+        Clock::time_point st = Clock::now();
+
+        mInheritors[idx]->resolveBatch(order);
+
+        spent[idx] =
+            std::chrono::duration<double>(Clock::now() - st).count();
+    });
+
+    double serial = 0;
+
+    for (double s : spent)
+        serial += s;
+
+    double orderTime = std::chrono::duration<double>(ordered - start).count();
+    double resolveTime =
+        std::chrono::duration<double>(Clock::now() - ordered).count();
+
+    LOG_INFO("InheritService: Resolved %zu inheritors over %zu objects in %f "
+             "seconds (order %f s, serial %f s, saved %f s)",
+             mInheritors.size(), order.size(), orderTime + resolveTime,
+             orderTime, serial, serial - resolveTime);
+}
+
 //------------------------------------------------------
 InheritQueryResultPtr InheritService::getSources(int objID) const {
     InheritMap::const_iterator it = mInheritSources.find(objID);
@@ -479,6 +649,33 @@ void InheritService::_createMPLink(int objID, int srcID, int priority) {
     mMetaPropRelation->createWithValue(objID, srcID, Variant(priority));
 }
 
+/*--------------------------------------------------------*/
+/*---------------------- InheritBatch --------------------*/
+/*--------------------------------------------------------*/
+InheritBatch::~InheritBatch() {
+    if (mEnded)
+        return;
+
+    try {
+        mInheritService->endBatch();
+    } catch (BasicException &e) {
+        LOG_ERROR("InheritBatch: Error ending the batch : %s",
+                  e.getDetails().c_str());
+    } catch (std::exception &e) {
+        LOG_ERROR("InheritBatch: Error ending the batch : %s", e.what());
+    } catch (...) {
+        LOG_ERROR("InheritBatch: Unknown error ending the batch");
+    }
+}
+
+//------------------------------------------------------
+void InheritBatch::end() {
+    assert(!mEnded);
+
+    mEnded = true;
+    mInheritService->endBatch();
+}
+
 //-------------------------- Factory implementation
 const std::string InheritServiceFactory::mName = "InheritService";
 
@@ -30,6 +30,7 @@
 #include "ServiceCommon.h"
 #include "InheritCommon.h"
 #include "Iterator.h"
+#include "NonCopyable.h"
 #include "OpdeService.h"
 #include "OpdeServiceFactory.h"
 #include "SharedPtr.h"
@@ -141,6 +142,20 @@ public:
     /// grows all the inheritors to be able to contain given range of object IDs
     void grow(int minID, int maxID);
 
+    /** Starts a batch of inheritance changes on all the inheritors. The
+     * inheritors propagate the changes once, in the matching endBatch. Meant
+     * to wrap mass changes, like database loads. Batches nest.
+     * @note The effective IDs are not up to date until the batch ends */
+    void beginBatch();
+
+    /** Ends the batch of inheritance changes. Ending the outermost batch
+     * resolves the collected changes of all the inheritors in parallel, one
+     * inheritor per task, then lets them broadcast the changes serially.
+     * @note The batch is ended on all the inheritors even if some of them
+     * throw, the first exception is rethrown after
+     * @see beginBatch */
+    void endBatch();
+
     /// Map of object (src/dst) to inherit link
     typedef std::unordered_map<int, InheritLink> InheritLinkMap;
 
@@ -177,6 +192,14 @@ private:
     /// Creates a new metaproperty link with the specified priority
     void _createMPLink(int objID, int srcID, int priority);
 
+    /** Computes the topological order of the inheritance graph (Kahn's
+     * algorithm). Objects in inheritance cycles are ranked after the rest */
+    void buildOrder(InheritOrder &order) const;
+
+    /** Resolves the batched changes of all the inheritors in parallel, over
+     * the once computed order. Logs the time spent */
+    void resolveBatch();
+
     /// Inheritance sources
     InheritMap mInheritSources;
 
@@ -203,6 +226,31 @@ private:
 
     /// All instanced inheritors are here
     InheritorList mInheritors;
+
+    /// Nesting depth of beginBatch calls
+    unsigned int mBatchDepth;
+};
+
+/** Scoped InheritService batch. @see InheritService::beginBatch
+ * @note Call end on the success path. If the scope is left by an exception
+ * instead, the destructor ends the batch, only logging the errors of the
+ * propagation (a throw while unwinding would terminate) */
+class InheritBatch : public NonCopyable {
+public:
+    InheritBatch(InheritService *is) : mInheritService(is), mEnded(false) {
+        mInheritService->beginBatch();
+    };
+
+    ~InheritBatch();
+
+    /// Ends the batch, propagating the changes. Can throw
+    void end();
+
+protected:
+    InheritService *mInheritService;
+
+    /// end was called already
+    bool mEnded;
 };
 
 /// Shared pointer to Inherit service
@@ -24,11 +24,14 @@
 #ifndef __LINKCOMMON_H
 #define __LINKCOMMON_H
 
+#include "File.h"
 #include "Iterator.h"
 #include "SharedPtr.h"
 #include "compat.h"
 #include "integers.h"
 
+#include <vector>
+
 namespace Opde {
 
 class Relation;
@@ -38,12 +41,36 @@ using RelationPtr = std::shared_ptr<Relation>;
 /// Link ID type. 32bit number at least...
 typedef unsigned int link_id_t;
 
+#pragma pack(push, 1)
 /// sLink-like, but this one contains id as well. Size: Fixed to 14 bytes
 struct LinkStruct {
     uint32_t id;
     int32_t src;
     int32_t dest;
     uint16_t flavor;
+
+    friend File &operator<<(File &st, const LinkStruct &ls) {
+        st << ls.id << ls.src << ls.dest << ls.flavor;
+        return st;
+    }
+
+    friend File &operator>>(File &st, LinkStruct &ls) {
+        st >> ls.id >> ls.src >> ls.dest >> ls.flavor;
+        return st;
+    }
+};
+#pragma pack(pop)
+
+/// Link structs are bulk readable, the mixed field sizes are swapped by hand
+template <> struct FileBulkTraits<LinkStruct> {
+    static const bool enabled = sizeof(LinkStruct) == 14;
+
+    static void swapEndian(LinkStruct *data, file_size_t count) {
+        for (file_size_t i = 0; i < count; ++i) {
+            File::swapEndian(&data[i].id, sizeof(uint32_t), 3);
+            File::swapEndian(&data[i].flavor, sizeof(uint16_t), 1);
+        }
+    }
 };
 
 /** A link container. Contains source, destination, ID, flavor and link data
@@ -116,13 +143,19 @@ enum LinkChangeType {
     /// Link has changed data (Sent after the change)
     LNK_CHANGED,
     /// All the links were removed from the relation (Sent before the cleanout)
-    LNK_RELATION_CLEARED
+    LNK_RELATION_CLEARED,
+    /// Links were loaded in bulk (Sent once after the whole load, instead of
+    /// LNK_ADDED per link)
+    LNK_RELATION_LOADED
 };
 
+/// List of links, as passed with LNK_RELATION_LOADED
+typedef std::vector<const Link *> LinkList;
+
 /// Link chage message
 struct LinkChangeMsg {
-    LinkChangeMsg() : link(nullptr) {};
-    LinkChangeMsg(const Link *lnk) : link(lnk) {};
+    LinkChangeMsg() : link(nullptr), links(nullptr) {};
+    LinkChangeMsg(const Link *lnk) : link(lnk), links(nullptr) {};
 
     /// A change that happened
     LinkChangeType change;
@@ -130,6 +163,8 @@ struct LinkChangeMsg {
     link_id_t linkID;
     /// The link itself. Do not modify!
     const Link *link;
+    /// All the loaded links for LNK_RELATION_LOADED, null otherwise
+    const LinkList *links;
 };
 
 /// Creates a link ID from flavor, concreteness and index
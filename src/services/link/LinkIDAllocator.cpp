@@ -0,0 +1,122 @@
+/******************************************************************************
+ *
+ *    This file is part of openDarkEngine project
+ *    Copyright (C) 2005-2009 openDarkEngine team
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	  $Id$
+ *
+ *****************************************************************************/
+
+#include <algorithm>
+
+#include "LinkIDAllocator.h"
+#include "format.h"
+
+namespace Opde {
+
+/// The highest index a link id can hold
+static const link_id_t MaxLinkIndex = 0x0FFFF;
+
+/*-----------------------------------------------------*/
+/*------------------- LinkIDAllocator -----------------*/
+/*-----------------------------------------------------*/
+LinkIDAllocator::LinkIDAllocator() : mMax(0), mCount(0) {}
+
+//------------------------------------
+link_id_t LinkIDAllocator::allocate() {
+    // reuse the freed indices first
+    while (!mFree.empty()) {
+        link_id_t idx = mFree.back();
+        mFree.pop_back();
+
+        // could have been reserved since it was freed
+        if (!mUsed.getBit(idx)) {
+            mUsed.setBit(idx, true);
+            ++mCount;
+            return idx;
+        }
+    }
+
+    if (mMax >= MaxLinkIndex)
+        OPDE_EXCEPT(format("All the ", MaxLinkIndex, " link ids are used"));
+
+    ++mMax;
+    grow(mMax);
+
+    mUsed.setBit(mMax, true);
+    ++mCount;
+
+    return mMax;
+}
+
+//------------------------------------
+bool LinkIDAllocator::reserve(link_id_t idx) {
+    assert(idx <= MaxLinkIndex);
+
+    if (isUsed(idx))
+        return false;
+
+    grow(idx);
+
+    if (idx > mMax) {
+        // the skipped indices are free
+        for (link_id_t gap = mMax + 1; gap < idx; ++gap)
+            mFree.push_back(static_cast<uint16_t>(gap));
+
+        mMax = idx;
+    }
+
+    mUsed.setBit(idx, true);
+    ++mCount;
+
+    return true;
+}
+
+//------------------------------------
+bool LinkIDAllocator::release(link_id_t idx) {
+    if (!isUsed(idx))
+        return false;
+
+    mUsed.setBit(idx, false);
+    mFree.push_back(static_cast<uint16_t>(idx));
+    --mCount;
+
+    return true;
+}
+
+//------------------------------------
+void LinkIDAllocator::clear() {
+    mUsed.clear();
+    mFree.clear();
+    mMax = 0;
+    mCount = 0;
+}
+
+//------------------------------------
+void LinkIDAllocator::grow(link_id_t idx) {
+    int maxIndex = mUsed.getMaxIndex();
+
+    if (static_cast<int>(idx) <= maxIndex)
+        return;
+
+    // geometric growth, so the bitmap is not reallocated per index
+    link_id_t size = std::max<link_id_t>(idx, maxIndex * 2 + 64);
+
+    mUsed.growMaxIndex(std::min(size, MaxLinkIndex));
+}
+
+} // namespace Opde
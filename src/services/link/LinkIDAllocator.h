@@ -0,0 +1,93 @@
+/******************************************************************************
+ *
+ *    This file is part of openDarkEngine project
+ *    Copyright (C) 2005-2009 openDarkEngine team
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	  $Id$
+ *
+ *****************************************************************************/
+
+#ifndef __LINKIDALLOCATOR_H
+#define __LINKIDALLOCATOR_H
+
+#include "config.h"
+
+#include "BitArray.h"
+#include "LinkCommon.h"
+
+#include <vector>
+
+namespace Opde {
+
+/** @brief Allocator of the link id indices of one concreteness level.
+ * Tracks the used indices in a bitmap, and keeps the freed ones on a free
+ * list, so both allocation and release are constant time and the freed
+ * indices get reused (the index part of a link id only has 16 bits).
+ *
+ * The state is not stored on it's own - loading the links reserves their ids,
+ * and the gaps between the reserved ids become free.
+ * @note Index 0 is never allocated */
+class LinkIDAllocator {
+public:
+    LinkIDAllocator();
+
+    /** Allocates a free index
+     * @return The allocated index
+     * @throw BasicException if all the indices are used */
+    link_id_t allocate();
+
+    /** Marks the given index as used (for ids of loaded links)
+     * @return false if the index was already used */
+    bool reserve(link_id_t idx);
+
+    /** Frees the given index for reuse
+     * @return false if the index was not used */
+    bool release(link_id_t idx);
+
+    /// @return true if the given index is used
+    bool isUsed(link_id_t idx) const {
+        return (static_cast<int>(idx) <= mUsed.getMaxIndex()) &&
+               mUsed.getBit(idx);
+    };
+
+    /// @return The count of the used indices
+    size_t getCount() const { return mCount; };
+
+    /// Frees all the indices
+    void clear();
+
+protected:
+    /// Grows the bitmap to cover the given index
+    void grow(link_id_t idx);
+
+    /// Bitmap of the used indices
+    BitArray mUsed;
+
+    /** Freed indices under mMax. Can contain indices reserved since, these
+     * are skipped on allocation */
+    std::vector<uint16_t> mFree;
+
+    /// The highest index ever used
+    link_id_t mMax;
+
+    /// Count of the used indices
+    size_t mCount;
+};
+
+} // namespace Opde
+
+#endif
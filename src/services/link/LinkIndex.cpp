@@ -0,0 +1,307 @@
+/******************************************************************************
+ *
+ *    This file is part of openDarkEngine project
+ *    Copyright (C) 2005-2009 openDarkEngine team
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	  $Id$
+ *
+ *****************************************************************************/
+
+#include <algorithm>
+#include <cassert>
+
+#include "LinkIndex.h"
+
+namespace Opde {
+
+/// Minimal delta buffer size that triggers the merge
+static const size_t MinDeltaSize = 64;
+
+/// The delta buffer is merged once it reaches 1/DeltaRatio of the index
+static const size_t DeltaRatio = 8;
+
+/// Sources spanning more than this many ids per entry use binary search
+static const size_t MaxOffsetSparsity = 4;
+
+/*-----------------------------------------------------*/
+/*--------------------- Comparators -------------------*/
+/*-----------------------------------------------------*/
+/// The full index order
+struct EntryLess {
+    bool operator()(const LinkIndex::Entry &a,
+                    const LinkIndex::Entry &b) const {
+        if (a.src != b.src)
+            return a.src < b.src;
+
+        if (a.dst != b.dst)
+            return a.dst < b.dst;
+
+        return a.id < b.id;
+    }
+};
+
+/// Source only order, for source queries
+struct SrcLess {
+    bool operator()(const LinkIndex::Entry &a,
+                    const LinkIndex::Entry &b) const {
+        return a.src < b.src;
+    }
+};
+
+/// Source, destination order, for source/destination queries
+struct SrcDstLess {
+    bool operator()(const LinkIndex::Entry &a,
+                    const LinkIndex::Entry &b) const {
+        if (a.src != b.src)
+            return a.src < b.src;
+
+        return a.dst < b.dst;
+    }
+};
+
+/// Creates the index entry of the link
+static inline LinkIndex::Entry makeEntry(const Link *link) {
+    LinkIndex::Entry e = {link->src(), link->dst(), link->id(), link};
+    return e;
+}
+
+/*-----------------------------------------------------*/
+/*--------------------- LinkIndex::Range --------------*/
+/*-----------------------------------------------------*/
+LinkIndex::Range::Range()
+    : mBegin(NULL), mEnd(NULL), mDeltaBegin(NULL), mDeltaEnd(NULL) {}
+
+//------------------------------------
+LinkIndex::Range::Range(const Entry *begin, const Entry *end,
+                        const Entry *deltaBegin, const Entry *deltaEnd)
+    : mBegin(begin), mEnd(end), mDeltaBegin(deltaBegin), mDeltaEnd(deltaEnd) {}
+
+//------------------------------------
+const Link &LinkIndex::Range::next() {
+    // the entries removed since the last call are skipped first
+    skipRemoved();
+
+    assert(!end());
+
+    const Entry *e;
+
+    // both parts are sorted, the smaller head goes first
+    if (mDeltaBegin == mDeltaEnd) {
+        e = mBegin++;
+    } else if (mBegin == mEnd || EntryLess()(*mDeltaBegin, *mBegin)) {
+        e = mDeltaBegin++;
+    } else {
+        e = mBegin++;
+    }
+
+    return *e->link;
+}
+
+//------------------------------------
+void LinkIndex::Range::seekAfter(const Entry &key) {
+    mBegin = std::upper_bound(mBegin, mEnd, key, EntryLess());
+    mDeltaBegin = std::upper_bound(mDeltaBegin, mDeltaEnd, key, EntryLess());
+}
+
+//------------------------------------
+void LinkIndex::Range::skipRemoved() const {
+    while (mBegin != mEnd && !mBegin->link)
+        ++mBegin;
+
+    while (mDeltaBegin != mDeltaEnd && !mDeltaBegin->link)
+        ++mDeltaBegin;
+}
+
+/*-----------------------------------------------------*/
+/*--------------------- LinkIndex ---------------------*/
+/*-----------------------------------------------------*/
+LinkIndex::LinkIndex() : mMinSrc(0), mRemoved(0), mCount(0), mEpoch(0) {}
+
+//------------------------------------
+void LinkIndex::clear() {
+    mEntries.clear();
+    mDelta.clear();
+    mOffsets.clear();
+    mMinSrc = 0;
+    mRemoved = 0;
+    mCount = 0;
+    ++mEpoch;
+}
+
+//------------------------------------
+void LinkIndex::insert(const Link *link) {
+    Entry e = makeEntry(link);
+
+    mDelta.insert(std::upper_bound(mDelta.begin(), mDelta.end(), e, EntryLess()),
+                  e);
+
+    ++mCount;
+    ++mEpoch;
+
+    if (mDelta.size() + mRemoved >
+        std::max(MinDeltaSize, mEntries.size() / DeltaRatio))
+        flush();
+}
+
+//------------------------------------
+bool LinkIndex::remove(const Link *link) {
+    Entry key = makeEntry(link);
+
+    // Only marks the entry, so the ranges being walked stay valid
+    Entries *parts[2] = {&mEntries, &mDelta};
+
+    for (Entries *part : parts) {
+        Entries::iterator it =
+            std::lower_bound(part->begin(), part->end(), key, EntryLess());
+
+        for (; it != part->end() && !EntryLess()(key, *it); ++it) {
+            if (it->link == link) {
+                it->link = NULL;
+                ++mRemoved;
+                --mCount;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+//------------------------------------
+void LinkIndex::rebuild(const LinkList &links) {
+    mEntries.clear();
+    mEntries.reserve(links.size());
+
+    for (const Link *link : links)
+        mEntries.push_back(makeEntry(link));
+
+    std::sort(mEntries.begin(), mEntries.end(), EntryLess());
+
+    mDelta.clear();
+    mRemoved = 0;
+    mCount = mEntries.size();
+    ++mEpoch;
+
+    buildOffsets();
+}
+
+//------------------------------------
+void LinkIndex::flush() {
+    if (mDelta.empty() && mRemoved == 0)
+        return;
+
+    Entries merged;
+    merged.reserve(mCount);
+
+    Entries::const_iterator it = mEntries.begin();
+    Entries::const_iterator dit = mDelta.begin();
+
+    EntryLess less;
+
+    while (it != mEntries.end() || dit != mDelta.end()) {
+        const Entry *e;
+
+        if (dit == mDelta.end() || (it != mEntries.end() && !less(*dit, *it)))
+            e = &*it++;
+        else
+            e = &*dit++;
+
+        if (e->link)
+            merged.push_back(*e);
+    }
+
+    mEntries.swap(merged);
+    mDelta.clear();
+    mRemoved = 0;
+    ++mEpoch;
+
+    buildOffsets();
+}
+
+//------------------------------------
+LinkIndex::Range LinkIndex::find(int src, int dst) const {
+    Entry key = {src, dst, 0, NULL};
+
+    const Entry *data = mEntries.data();
+    const Entry *begin = data;
+    const Entry *end = data;
+
+    if (!mOffsets.empty()) {
+        // unsigned compare covers the ids under the range as well
+        size_t idx = static_cast<size_t>(static_cast<int64_t>(src) - mMinSrc);
+
+        if (idx + 1 < mOffsets.size()) {
+            begin = data + mOffsets[idx];
+            end = data + mOffsets[idx + 1];
+        }
+    } else {
+        std::pair<const Entry *, const Entry *> r =
+            std::equal_range(data, data + mEntries.size(), key, SrcLess());
+        begin = r.first;
+        end = r.second;
+    }
+
+    const Entry *delta = mDelta.data();
+    std::pair<const Entry *, const Entry *> dr;
+
+    if (dst != 0) {
+        std::pair<const Entry *, const Entry *> r =
+            std::equal_range(begin, end, key, SrcDstLess());
+        begin = r.first;
+        end = r.second;
+
+        dr = std::equal_range(delta, delta + mDelta.size(), key, SrcDstLess());
+    } else {
+        dr = std::equal_range(delta, delta + mDelta.size(), key, SrcLess());
+    }
+
+    return Range(begin, end, dr.first, dr.second);
+}
+
+//------------------------------------
+void LinkIndex::buildOffsets() {
+    mOffsets.clear();
+
+    if (mEntries.empty())
+        return;
+
+    mMinSrc = mEntries.front().src;
+
+    size_t span = static_cast<size_t>(
+        static_cast<int64_t>(mEntries.back().src) - mMinSrc + 1);
+
+    // too sparse sources would waste memory, these are binary searched
+    if (span > mEntries.size() * MaxOffsetSparsity + MinDeltaSize)
+        return;
+
+    mOffsets.resize(span + 1);
+
+    size_t pos = 0;
+
+    for (size_t idx = 0; idx < span; ++idx) {
+        int src = mMinSrc + static_cast<int>(idx);
+
+        while (pos < mEntries.size() && mEntries[pos].src < src)
+            ++pos;
+
+        mOffsets[idx] = static_cast<uint32_t>(pos);
+    }
+
+    mOffsets[span] = static_cast<uint32_t>(mEntries.size());
+}
+
+} // namespace Opde
@@ -0,0 +1,159 @@
+/******************************************************************************
+ *
+ *    This file is part of openDarkEngine project
+ *    Copyright (C) 2005-2009 openDarkEngine team
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	  $Id$
+ *
+ *****************************************************************************/
+
+#ifndef __LINKINDEX_H
+#define __LINKINDEX_H
+
+#include "config.h"
+
+#include "LinkCommon.h"
+
+#include <vector>
+
+namespace Opde {
+
+/** @brief Source/destination query index of the links of one relation.
+ * The links are referenced from one flat array sorted by (src, dst, link id),
+ * with the entry offsets of every source object precomputed (CSR layout), so
+ * a query is a contiguous range of the array.
+ *
+ * Inserted links go to a small sorted delta buffer, merged into the main array
+ * once it grows over a fraction of the index size. Removed links are only
+ * marked (link pointer set to NULL), and are dropped on the next merge.
+ * @note The index does not own the links - the pointers have to stay valid
+ * while indexed (Relation points into it's LinkMap)
+ */
+class LinkIndex {
+public:
+    /// One indexed link. Src and dst are copied for cache friendly scans
+    struct Entry {
+        int src;
+        int dst;
+        link_id_t id;
+        /// The indexed link, NULL if removed
+        const Link *link;
+    };
+
+    typedef std::vector<Entry> Entries;
+
+    /** A query result - the matching part of the main array and the matching
+     * part of the delta buffer, walked in (dst, link id) order
+     * @note Valid until the next insert, flush, rebuild or clear of the index.
+     * Removal keeps it valid */
+    class Range {
+    public:
+        Range();
+        Range(const Entry *begin, const Entry *end, const Entry *deltaBegin,
+              const Entry *deltaEnd);
+
+        /// @return true if there are no more live links in the range
+        bool end() const {
+            skipRemoved();
+            return (mBegin == mEnd) && (mDeltaBegin == mDeltaEnd);
+        };
+
+        /// @return The next link of the range. Range must not be at the end
+        const Link &next();
+
+        /** Skips all the entries up to and including the given key (in the
+         * src, dst, link id order). Used to continue a walk in a range found
+         * again after the original range got invalidated */
+        void seekAfter(const Entry &key);
+
+    protected:
+        /** Skips the removed entries of both parts. Done on every access, as
+         * the links can get removed while the range is walked */
+        void skipRemoved() const;
+
+        /// The cursors only skip the removed entries in the const methods
+        mutable const Entry *mBegin;
+        const Entry *mEnd;
+        mutable const Entry *mDeltaBegin;
+        const Entry *mDeltaEnd;
+    };
+
+    LinkIndex();
+
+    /// Removes all the links from the index
+    void clear();
+
+    /** Inserts a link to the index (to the delta buffer). Can trigger a merge
+     * @param link The link to index. Has to stay valid while indexed */
+    void insert(const Link *link);
+
+    /** Marks the link as removed
+     * @return false if the link was not found in the index */
+    bool remove(const Link *link);
+
+    /** Rebuilds the whole index from the given links in one sorting pass
+     * @param links The links to index, in any order */
+    void rebuild(const LinkList &links);
+
+    /** Merges the delta buffer into the main array, dropping the removed
+     * links. Leaves all the links in the range scanned main array */
+    void flush();
+
+    /** Finds all the links from src to dst
+     * @param src The source object id
+     * @param dst The destination object id, or 0 for any destination
+     * @return The range of the matching links */
+    Range find(int src, int dst) const;
+
+    /// @return The count of the indexed links
+    size_t size() const { return mCount; };
+
+    /** @return The structural change counter. Changes whenever the live Range
+     * instances get invalidated */
+    unsigned int getEpoch() const { return mEpoch; };
+
+protected:
+    /// Recomputes the per source offsets of the main array
+    void buildOffsets();
+
+    /// Sorted main array of the links
+    Entries mEntries;
+
+    /// Sorted recently inserted links
+    Entries mDelta;
+
+    /** Offsets of the entries of the sources in mEntries, one per source id
+     * starting with mMinSrc, plus the end offset. Empty if the source ids are
+     * too sparse - binary search is used then */
+    std::vector<uint32_t> mOffsets;
+
+    /// The first source id covered by mOffsets
+    int mMinSrc;
+
+    /// Count of the entries marked removed
+    size_t mRemoved;
+
+    /// Count of the live links
+    size_t mCount;
+
+    /// Structural change counter
+    unsigned int mEpoch;
+};
+
+} // namespace Opde
+
+#endif
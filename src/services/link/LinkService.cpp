@@ -25,10 +25,12 @@
 
 #include "format.h"
 #include "LinkService.h"
+#include "ConsoleBackend.h"
 #include "FileGroup.h"
 #include "OpdeServiceManager.h"
 #include "ServiceCommon.h"
 #include "database/DatabaseService.h"
+#include "inherit/InheritService.h"
 #include "logger.h"
 #include "Relation.h"
 
@@ -65,7 +67,8 @@ protected:
 template <> const size_t ServiceImpl<LinkService>::SID = __SERVICE_ID_LINK;
 
 LinkService::LinkService(ServiceManager *manager, const std::string &name)
-    : ServiceImpl<Opde::LinkService>(manager, name), mDatabaseService(NULL) {}
+    : ServiceImpl<Opde::LinkService>(manager, name), mDatabaseService(NULL),
+      mInheritListenerID(0) {}
 
 //------------------------------------------------------
 LinkService::~LinkService() {
@@ -84,10 +87,75 @@ void LinkService::bootstrapFinished() {
     mServiceManager->createByMask(SERVICE_LINK_LISTENER);
 
     mDatabaseService = GET_SERVICE(DatabaseService);
+
+    // Inheritance changes invalidate the inherited link caches
+    mInheritService = GET_SERVICE(InheritService);
+
+    InheritService::ListenerPtr inheritCallback(
+        new ClassCallback<InheritChangeMsg, LinkService>(
+            this, &LinkService::onInheritMsg));
+
+    mInheritListenerID = mInheritService->registerListener(inheritCallback);
+
+    ConsoleBackend::getSingleton().registerCommandListener(
+        "linkcache", dynamic_cast<ConsoleCommandListener *>(this));
+    ConsoleBackend::getSingleton().setCommandHint(
+        "linkcache", "Inherited link cache statistics. 'reset' zeroes them");
 }
 
 //------------------------------------------------------
-void LinkService::shutdown() { mDatabaseService.reset(); }
+void LinkService::shutdown() {
+    if (mInheritService)
+        mInheritService->unregisterListener(mInheritListenerID);
+
+    mInheritService.reset();
+    mDatabaseService.reset();
+}
+
+//------------------------------------------------------
+void LinkService::onInheritMsg(const InheritChangeMsg &msg) {
+    for (auto &rel : mRelationNameMap) {
+        if (msg.change == INH_CLEARED_ALL)
+            rel.second->clearInheritedCache();
+        else
+            rel.second->inheritanceChanged(msg.dstID);
+    }
+}
+
+//------------------------------------------------------
+void LinkService::commandExecuted(std::string command,
+                                  std::string parameters) {
+    if (command != "linkcache")
+        return;
+
+    size_t hits = 0, misses = 0;
+
+    for (auto &rel : mRelationNameMap) {
+        if (parameters == "reset") {
+            rel.second->resetInheritedCacheStats();
+            continue;
+        }
+
+        size_t relHits = rel.second->getInheritedCacheHits();
+        size_t relMisses = rel.second->getInheritedCacheMisses();
+
+        if (relHits + relMisses == 0)
+            continue;
+
+        ConsoleBackend::getSingleton().putMessage(
+            format(rel.first, " : ", relHits, " hits, ", relMisses,
+                   " misses, ", rel.second->getInheritedCacheSize(),
+                   " cached"));
+
+        hits += relHits;
+        misses += relMisses;
+    }
+
+    if (parameters != "reset")
+        ConsoleBackend::getSingleton().putMessage(
+            format("Inherited link cache total : ", hits, " hits, ", misses,
+                   " misses"));
+}
 
 //------------------------------------------------------
 void LinkService::load(const FileGroupPtr &db, const BitArray &objMask) {
@@ -176,6 +244,22 @@ void LinkService::load(const FileGroupPtr &db, const BitArray &objMask) {
     }
 }
 
+//------------------------------------------------------
+void LinkService::getLoadChunks(std::vector<std::string> &chunks) {
+    chunks.push_back("Relations");
+
+    RelationNameMap::iterator it = mRelationNameMap.begin();
+
+    for (; it != mRelationNameMap.end(); ++it) {
+        // inverse relations are loaded with their normal counterparts
+        if (it->second->isInverse())
+            continue;
+
+        chunks.push_back("L$" + it->second->getName());
+        chunks.push_back("LD$" + it->second->getName());
+    }
+}
+
 //------------------------------------------------------
 void LinkService::save(const FileGroupPtr &db, uint saveMask) {
     // Iterates through all the relations. Writes the name into the Relations
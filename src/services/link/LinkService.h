@@ -29,6 +29,7 @@
 #include "DataStorage.h"
 
 #include "BitArray.h"
+#include "ConsoleCommandListener.h"
 #include "LinkCommon.h"
 #include "OpdeService.h"
 #include "OpdeServiceFactory.h"
@@ -38,13 +39,15 @@ namespace Opde {
 
 class Relation;
 class DataStorage;
+struct InheritChangeMsg;
 
 using RelationPtr = std::shared_ptr<Relation>;
 using DataStoragePtr = std::shared_ptr<DataStorage>;
 
 /** @brief Link service - service managing in-game object links
  */
-class LinkService : public ServiceImpl<LinkService> {
+class LinkService : public ServiceImpl<LinkService>,
+                    public ConsoleCommandListener {
 public:
     LinkService(ServiceManager *manager, const std::string &name);
 
@@ -101,6 +104,11 @@ public:
      * objects have to be here, otherwise link gets ignored */
     void load(const FileGroupPtr &db, const BitArray &objMask);
 
+    /** Lists the chunks load reads. The relations are listed in the name
+     * order, as the order of the Relations chunk is not known beforehand
+     * @param chunks The chunk names to append to */
+    void getLoadChunks(std::vector<std::string> &chunks);
+
     /** Saves the links and link data according to the saveMask */
     void save(const FileGroupPtr &db, uint saveMask);
 
@@ -153,11 +161,19 @@ public:
      */
     const DataFields &getFieldDesc(int flavor);
 
+    /** Console command handler. "linkcache" lists the inherited link cache
+     * statistics of the relations, "linkcache reset" zeroes them */
+    void commandExecuted(std::string command, std::string parameters);
+
 protected:
     bool init();
     void bootstrapFinished();
     void shutdown();
 
+    /** Inheritance change listener. Invalidates the inherited link caches of
+     * the relations */
+    void onInheritMsg(const InheritChangeMsg &msg);
+
     /** request a mapping Name->Flavor and reverse
      * @param id The flavor value requested
      * @param name The name for that flavor (Relation name)
@@ -185,6 +201,12 @@ protected:
 
     /// Database service
     DatabaseServicePtr mDatabaseService;
+
+    /// Inherit service, for the inheritance change messages
+    InheritServicePtr mInheritService;
+
+    /// Inheritance change listener ID
+    MessageListenerID mInheritListenerID;
 };
 
 /// Factory for the LinkService objects
@@ -23,6 +23,7 @@
 
 
 #include <stack>
+#include <unordered_set>
 
 #include "Relation.h"
 #include "LinkCommon.h"
@@ -42,87 +43,118 @@ static size_t LinkStructSize = 14;
 /// Single source link query (multiple targets), or in reverse
 class Relation::MultiTargetLinkQueryResult : public LinkQueryResult {
 public:
-    MultiTargetLinkQueryResult(const Relation::ObjectIDToLinks &linkmap,
-                               Relation::ObjectIDToLinks::const_iterator begin,
-                               Relation::ObjectIDToLinks::const_iterator end)
-        :
-
-          LinkQueryResult(), mLinkMap(linkmap), mBegin(begin), mEnd(end) {
-        mIter = mBegin;
-    }
+    MultiTargetLinkQueryResult(const LinkIndex &index, int src, int dst)
+        : LinkQueryResult(), mIndex(index), mSrc(src), mDst(dst),
+          mEpoch(index.getEpoch()), mRange(index.find(src, dst)),
+          mStarted(false), mLastDst(0), mLastID(0) {}
 
     virtual const Link &next() {
-        assert(!end());
+        revalidate();
 
-        const Link &l = mIter->second;
+        assert(!mRange.end());
 
-        ++mIter;
+        const Link &l = mRange.next();
+
+        mStarted = true;
+        mLastDst = l.dst();
+        mLastID = l.id();
 
         return l;
     }
 
-    virtual bool end() const { return (mIter == mEnd); }
+    virtual bool end() const {
+        revalidate();
+        return mRange.end();
+    }
 
 protected:
-    const Relation::ObjectIDToLinks &mLinkMap;
-    Relation::ObjectIDToLinks::const_iterator mIter, mBegin, mEnd;
+    /** Link creation invalidates the range (the result can outlive the call,
+     * e.g. in the python bindings). The range is found again then, and the
+     * walk continues after the last returned link */
+    void revalidate() const {
+        if (mEpoch == mIndex.getEpoch())
+            return;
+
+        mEpoch = mIndex.getEpoch();
+        mRange = mIndex.find(mSrc, mDst);
+
+        if (mStarted) {
+            LinkIndex::Entry last = {mSrc, mLastDst, mLastID, NULL};
+            mRange.seekAfter(last);
+        }
+    }
+
+    const LinkIndex &mIndex;
+    int mSrc;
+    int mDst;
+
+    mutable unsigned int mEpoch;
+    mutable LinkIndex::Range mRange;
+
+    /// The key of the last returned link, to continue after
+    bool mStarted;
+    int mLastDst;
+    link_id_t mLastID;
 };
 
-/// Link query that walks all ancestral objects as well
+/// Link query over the cached links of an object and it's ancestors
 class Relation::InheritedMultiTargetLinkQueryResult : public LinkQueryResult {
 public:
-    InheritedMultiTargetLinkQueryResult(int objID, int dstID,
-                                        const Relation *rel)
-        : mOwner(rel), mSrcID(objID), mDstID(dstID) {
-        // we need inherit service so we can ask for all object's sources
-        mInheritService = GET_SERVICE(InheritService);
-        mAncestorStack.push(mSrcID);
-    }
-
-    ~InheritedMultiTargetLinkQueryResult() { mInheritService.reset(); }
+    InheritedMultiTargetLinkQueryResult(
+        const LinkMap &linkMap, const shared_ptr<const InheritedLinks> &links,
+        int dstID)
+        : mLinkMap(linkMap), mLinks(links), mIter(links->begin()),
+          mDstID(dstID), mCurrent(NULL) {}
 
     virtual const Link &next() {
-        // see if we have any more in the current iterator
-        if (mCurrentIt || mCurrentIt->end()) {
-            pollNextAncestor();
-        }
+        // the links removed since the last call are skipped first
+        skipInvalid();
+
+        assert(mCurrent);
+
+        const Link &l = *mCurrent;
+
+        ++mIter;
+        mCurrent = NULL;
 
-        assert(mCurrentIt);
-        return mCurrentIt->next();
+        return l;
     }
 
     virtual bool end() const {
-        if (!mCurrentIt)
-            return mAncestorStack.empty();
-        else
-            return mCurrentIt->end() && mAncestorStack.empty();
+        skipInvalid();
+        return mIter == mLinks->end();
     }
 
 protected:
-    void pollNextAncestor() {
-        if (mAncestorStack.empty())
-            return;
-
-        int curId = mAncestorStack.top();
-
-        // ask inherit service for list of ancestors
-        InheritQueryResultPtr anci = mInheritService->getSources(curId);
-
-        while (!anci->end()) {
-            const InheritLink &l = anci->next();
-            mAncestorStack.push(l.srcID);
+    /** Moves to the next cached link that still exists and goes to the
+     * requested destination, looking it up into mCurrent */
+    void skipInvalid() const {
+        for (; mIter != mLinks->end(); ++mIter) {
+            if (mDstID != 0 && mIter->dst != mDstID)
+                continue;
+
+            LinkMap::const_iterator it = mLinkMap.find(mIter->id);
+
+            if (it != mLinkMap.end() && it->second.src() == mIter->src &&
+                it->second.dst() == mIter->dst) {
+                mCurrent = &it->second;
+                return;
+            }
         }
 
-        // and unroll into the iterator
-        mCurrentIt = mOwner->getAllLinks(curId, mDstID);
+        mCurrent = NULL;
     }
 
-    LinkQueryResultPtr mCurrentIt;
-    std::stack<int> mAncestorStack;
-    InheritServicePtr mInheritService;
-    const Relation *mOwner;
-    int mSrcID;
+    const LinkMap &mLinkMap;
+
+    /// Holds the list even if the cache entry gets invalidated meanwhile
+    shared_ptr<const InheritedLinks> mLinks;
+
+    mutable InheritedLinks::const_iterator mIter;
     int mDstID;
+
+    /// The link at mIter, valid after skipInvalid
+    mutable const Link *mCurrent;
 };
 
 /*-----------------------------------------------------*/
@@ -130,13 +162,9 @@ protected:
 /*-----------------------------------------------------*/
 Relation::Relation(const std::string &name, const DataStoragePtr &stor,
                    bool isInverse, bool hidden)
-    : mSrcDstLinkMap(), mID(-1), mName(name), mStorage(stor), mHidden(hidden),
-      mLinkMap(), mInverse(NULL), mIsInverse(isInverse) {
-
-    // clear out the maximal ID info
-    for (int i = 0; i < 16; ++i) {
-        mMaxID[i] = 0;
-    }
+    : mSrcDstIndex(), mID(-1), mName(name), mStorage(stor), mHidden(hidden),
+      mLinkMap(), mInverse(NULL), mIsInverse(isInverse),
+      mInheritedCacheHits(0), mInheritedCacheMisses(0) {
 
     if (!stor)
         mFakeSize = 0;
@@ -260,10 +288,16 @@ void Relation::load(const FileGroupPtr &db, const BitArray &objMask) {
         }
     }
 
-    for (unsigned int idx = 0; idx < link_count; idx++) {
-        LinkStruct slink;
-        *flink >> slink.id >> slink.src >> slink.dest >> slink.flavor;
+    // all the links are read at once
+    std::vector<LinkStruct> slinks;
+    flink->read_vector(slinks, link_count);
+
+    // decode the whole chunk first, then insert in one batch per direction
+    std::vector<Link> links, inverses;
+    links.reserve(slinks.size());
+    inverses.reserve(slinks.size());
 
+    for (const LinkStruct &slink : slinks) {
         Link link{slink};
 
         LOG_VERBOSE("Relation (%s - %d): Read link ID %d, from %d to %d "
@@ -275,16 +309,14 @@ void Relation::load(const FileGroupPtr &db, const BitArray &objMask) {
         // Check if the flavor fits
         // The mID can't be negative, but just for sure:
         assert(mID >= 0);
-        assert(LINK_ID_FLAVOR(link->mID) ==
+        assert(LINK_ID_FLAVOR(link.id()) ==
                static_cast<unsigned int>(mID)); // keep compiler happy
 
         // Look if we fit into the mask
         if (objMask[link.src()] && objMask[link.dst()]) {
-            // Add link, notify listeners... Will search for data and throw if
-            // did not find them
-            _addLink(link);
+            links.push_back(link);
             // Inverse relation will get an inverse link to use
-            mInverse->_addLink(link.inverse());
+            inverses.push_back(link.inverse());
         } else {
             // the mask says no to the link!
             LOG_ERROR("Relation (%s - %d): Link (ID %d, %d to %d) thrown away "
@@ -297,6 +329,11 @@ void Relation::load(const FileGroupPtr &db, const BitArray &objMask) {
         }
     }
 
+    // Add links, notify listeners once... Will search for data and throw if
+    // did not find them
+    _addLinks(links);
+    mInverse->_addLinks(inverses);
+
     LOG_DEBUG("Relation (%s - %d): Done!", mName.c_str(), mID);
 }
 
@@ -324,6 +361,9 @@ void Relation::save(const FileGroupPtr &db, uint saveMask) {
     // no problem sorting those by link_id_t just write the links as they go,
     // and write the data in parallel
     // Write the links
+    std::vector<LinkStruct> slinks;
+    slinks.reserve(mLinkMap.size());
+
     for (auto &lr : mLinkMap) {
         const auto &link = lr.second;
 
@@ -331,8 +371,7 @@ void Relation::save(const FileGroupPtr &db, uint saveMask) {
         int conc = LINK_ID_CONCRETE(link.id());
 
         if (saveMask & (1 << conc)) { // mask says save!
-            LinkStruct slink = link.toStruct();
-            *flnk << slink.id << slink.src << slink.dest << slink.flavor;
+            slinks.push_back(link.toStruct());
         } else {
             LOG_DEBUG("Relation (%s): Link concreteness of link %d was out of "
                       "requested : %d",
@@ -340,13 +379,11 @@ void Relation::save(const FileGroupPtr &db, uint saveMask) {
         }
     }
 
+    flnk->write_vector(slinks);
+
     // if data are used, store
     if (mStorage) {
-        IntIteratorPtr idit = mStorage->getAllStoredObjects();
-
-        while (!idit->end()) {
-            int32_t id = idit->next();
-
+        mStorage->forEachStored([&](int32_t id) {
             // Test against the link write mask
             int conc = LINK_ID_CONCRETE(id);
 
@@ -362,7 +399,7 @@ void Relation::save(const FileGroupPtr &db, uint saveMask) {
                               "object %d. Property was not loaded",
                               mName.c_str(), id);
             }
-        }
+        });
     }
 }
 
@@ -393,15 +430,16 @@ void Relation::clear() {
     // Inform the listeners about the change of data
     broadcastMessage(m);
 
+    mInheritedCache.clear();
+    mSrcDstIndex.clear();
     mLinkMap.clear();
-    mSrcDstLinkMap.clear();
 
     if (mStorage)
         mStorage->clear();
 
-    // clear maximal link id's
+    // free all the link id's
     for (int i = 0; i < 16; ++i) {
-        mMaxID[i] = 0;
+        mIDAllocators[i].clear();
     }
 
     // Done...
@@ -418,7 +456,14 @@ link_id_t Relation::create(int from, int to) {
     link_id_t id = getFreeLinkID(cidx);
 
     Link newl{id, from, to, mID};
-    mStorage->create(id);
+
+    // the id stays free if the storage refuses it
+    try {
+        mStorage->create(id);
+    } catch (...) {
+        unallocateLinkID(id);
+        throw;
+    }
 
     // Last, insert the link to the database and notify
     _addLink(newl);
@@ -440,7 +485,13 @@ link_id_t Relation::createWithValues(int from, int to,
 
     Link newl{id, from, to, mID};
 
-    mStorage->createWithValues(id, dataValues);
+    // the id stays free if the storage refuses it
+    try {
+        mStorage->createWithValues(id, dataValues);
+    } catch (...) {
+        unallocateLinkID(id);
+        throw;
+    }
 
     // Last, insert the link to the database and notify
     _addLink(newl);
@@ -461,7 +512,13 @@ link_id_t Relation::createWithValue(int from, int to, const Variant &value) {
 
     Link newl{id, from, to, mID};
 
-    mStorage->createWithValue(id, value);
+    // the id stays free if the storage refuses it
+    try {
+        mStorage->createWithValue(id, value);
+    } catch (...) {
+        unallocateLinkID(id);
+        throw;
+    }
 
     // Last, insert the link to the database and notify
     _addLink(newl);
@@ -518,43 +575,68 @@ LinkQueryResultPtr Relation::getAllLinks(int src, int dst) const {
     // based on case of the query, return result
     assert(src != 0); // Source can't be zero
 
-    if (dst == 0) { // all link destinations
+    // dst == 0 means all link destinations
+    if (!mSrcDstIndex.find(src, dst).end())
+        return LinkQueryResultPtr(
+            new MultiTargetLinkQueryResult(mSrcDstIndex, src, dst));
 
-        ObjectLinkMap::const_iterator r = mSrcDstLinkMap.find(src);
+    LinkQueryResultPtr r(new EmptyLinkQueryResult());
+    return r;
+}
 
-        if (r != mSrcDstLinkMap.end()) {
-            LinkQueryResultPtr res(new MultiTargetLinkQueryResult(
-                r->second, r->second.begin(), r->second.end()));
-            return res;
-        }
+// --------------------------------------------------------------------------
+LinkQueryResultPtr Relation::getAllInherited(int src, int dst) const {
+    assert(src != 0); // Source can't be zero
 
-    } else { // both dst is nonzero (one link destination)
-        ObjectLinkMap::const_iterator r = mSrcDstLinkMap.find(src);
+    InheritedCache::iterator it = mInheritedCache.find(src);
 
-        if (r != mSrcDstLinkMap.end()) {
-            // all the components of the secondary map go into the set
-            ObjectIDToLinks::const_iterator ri = r->second.find(dst);
+    if (it != mInheritedCache.end()) {
+        ++mInheritedCacheHits;
+    } else {
+        ++mInheritedCacheMisses;
 
-            if (ri != r->second.end()) {
-                LinkQueryResultPtr res(new MultiTargetLinkQueryResult(
-                    r->second, ri, r->second.upper_bound(dst)));
-                return res;
-            }
-        }
+        shared_ptr<InheritedLinks> links(new InheritedLinks());
+        collectInherited(src, *links);
+
+        it = mInheritedCache.emplace(src, links).first;
     }
 
-    LinkQueryResultPtr r(new EmptyLinkQueryResult());
-    return r;
+    return LinkQueryResultPtr(
+        new InheritedMultiTargetLinkQueryResult(mLinkMap, it->second, dst));
 }
 
 // --------------------------------------------------------------------------
-LinkQueryResultPtr Relation::getAllInherited(int src, int dst) const {
-    assert(src != 0); // Source can't be zero
+void Relation::inheritanceChanged(int objID) {
+    // Nothing cached, nothing to invalidate (the usual case while loading)
+    if (mInheritedCache.empty())
+        return;
 
-    return LinkQueryResultPtr(
-        new InheritedMultiTargetLinkQueryResult(src, dst, this));
+    InheritServicePtr inheritService = GET_SERVICE(InheritService);
+
+    // the object and all it's descendants could have inherited the links
+    std::unordered_set<int> visited;
+    std::stack<int> pending;
+    pending.push(objID);
+
+    while (!pending.empty()) {
+        int id = pending.top();
+        pending.pop();
+
+        if (!visited.insert(id).second)
+            continue;
+
+        mInheritedCache.erase(id);
+
+        InheritQueryResultPtr targets = inheritService->getTargets(id);
+
+        while (!targets->end())
+            pending.push(targets->next().dstID);
+    }
 }
 
+// --------------------------------------------------------------------------
+void Relation::clearInheritedCache() { mInheritedCache.clear(); }
+
 // --------------------------------------------------------------------------
 const Link *Relation::getOneLink(int src, int dst) const {
     LinkQueryResultPtr res = getAllLinks(src, dst);
@@ -588,6 +670,49 @@ void Relation::objectDestroyed(int id) {
     mInverse->_objectDestroyed(id);
 }
 
+// --------------------------------------------------------------------------
+FieldHandle Relation::getFieldHandle(const std::string &field) {
+    if (mStorage)
+        return mStorage->getFieldHandle(field);
+
+    return FieldHandle();
+}
+
+// --------------------------------------------------------------------------
+bool Relation::setLinkField(link_id_t id, FieldHandle field,
+                            const Variant &value) {
+    if (mStorage && mStorage->setField(id, field, value)) {
+        LinkChangeMsg m;
+
+        m.change = LNK_CHANGED;
+        m.linkID = id;
+
+        // Inform the listeners about the change of data
+        broadcastMessage(m);
+
+        return true;
+    } else {
+        LOG_ERROR(
+            "Relation::setLinkField : Link %d was not found in relation %d", id,
+            mID);
+        return false;
+    }
+}
+
+// --------------------------------------------------------------------------
+Variant Relation::getLinkField(link_id_t id, FieldHandle field) {
+    Variant value;
+
+    if (mStorage && mStorage->getField(id, field, value)) {
+        return value;
+    } else {
+        LOG_ERROR(
+            "Relation::getLinkField : Link %d was not found in relation %d", id,
+            mID);
+        return Variant();
+    }
+}
+
 // --------------------------------------------------------------------------
 const DataFields &Relation::getFieldDesc(void) {
     if (mStorage) {
@@ -598,6 +723,40 @@ const DataFields &Relation::getFieldDesc(void) {
     }
 }
 
+// --------------------------------------------------------------------------
+void Relation::collectInherited(int objID, InheritedLinks &links) const {
+    // we need inherit service so we can ask for all object's sources
+    InheritServicePtr inheritService = GET_SERVICE(InheritService);
+
+    std::unordered_set<int> visited;
+    std::stack<int> ancestors;
+    ancestors.push(objID);
+
+    while (!ancestors.empty()) {
+        int curID = ancestors.top();
+        ancestors.pop();
+
+        // metaproperties can be reached by more than one path
+        if (!visited.insert(curID).second)
+            continue;
+
+        LinkIndex::Range range = mSrcDstIndex.find(curID, 0);
+
+        while (!range.end()) {
+            const Link &l = range.next();
+
+            InheritedLink il = {l.id(), l.src(), l.dst()};
+            links.push_back(il);
+        }
+
+        // ask inherit service for list of ancestors
+        InheritQueryResultPtr anci = inheritService->getSources(curID);
+
+        while (!anci->end())
+            ancestors.push(anci->next().srcID);
+    }
+}
+
 // --------------------------------------------------------------------------
 void Relation::_addLink(const Link &link) {
     // Insert, and detect the presence of such link already inserted (same ID)
@@ -619,10 +778,8 @@ void Relation::_addLink(const Link &link) {
         allocateLinkID(link.id());
 
         // Update the query databases
-        // Src->Dst->LinkList
-        std::pair<ObjectLinkMap::iterator, bool> r =
-            mSrcDstLinkMap.insert(make_pair(link.src(), ObjectIDToLinks()));
-        r.first->second.emplace(link.dst(), link);
+        mSrcDstIndex.insert(&ires.first->second);
+        inheritanceChanged(link.src());
 
         // fire the notification about inserted link
         LinkChangeMsg m(&ires.first->second);
@@ -635,6 +792,59 @@ void Relation::_addLink(const Link &link) {
     }
 }
 
+// --------------------------------------------------------------------------
+void Relation::_addLinks(const std::vector<Link> &links) {
+    // Verify link data exist, before touching anything
+    if (mStorage) {
+        for (const Link &link : links) {
+            if (!mStorage->has(link.id()))
+                OPDE_EXCEPT(format("Relation (", mName,
+                                   "): Link Data not defined prior to link "
+                                   "insertion for link id ", link.id()));
+        }
+    }
+
+    LinkList added;
+    added.reserve(links.size());
+
+    for (const Link &link : links) {
+        std::pair<LinkMap::iterator, bool> ires =
+            mLinkMap.emplace(link.id(), link);
+
+        if (!ires.second) {
+            LOG_ERROR("Relation: Found link with conflicting ID in relation %d "
+                      "(%s): ID: %d (stored %d) - link already existed",
+                      mID, mName.c_str(), link.id(), ires.first->second.id());
+            continue;
+        }
+
+        // Update the free link info
+        allocateLinkID(link.id());
+
+        added.push_back(&ires.first->second);
+    }
+
+    // The query database is rebuilt in one sorting pass
+    LinkList all;
+    all.reserve(mLinkMap.size());
+
+    for (const auto &lr : mLinkMap)
+        all.push_back(&lr.second);
+
+    mSrcDstIndex.rebuild(all);
+    mInheritedCache.clear();
+
+    // fire the one notification about all the inserted links
+    LinkChangeMsg m;
+
+    m.change = LNK_RELATION_LOADED;
+    m.linkID = 0; // all loaded links, no meaning
+    m.links = &added;
+
+    // Inform the listeners about the change
+    broadcastMessage(m);
+}
+
 // --------------------------------------------------------------------------
 void Relation::_removeLink(link_id_t id) {
     LinkMap::iterator it = mLinkMap.find(id);
@@ -645,25 +855,11 @@ void Relation::_removeLink(link_id_t id) {
         Link &to_remove = it->second;
 
         // Update the query databases
-        // SrcDst
-        ObjectLinkMap::iterator r = mSrcDstLinkMap.find(to_remove.src());
+        if (!mSrcDstIndex.remove(&to_remove))
+            LOG_ERROR("Relation %d: Link %d was missing in the query index",
+                      mID, id);
 
-        assert(r != mSrcDstLinkMap.end());
-
-        ObjectIDToLinks::iterator ri = r->second.find(to_remove.dst());
-        ObjectIDToLinks::iterator rend = r->second.upper_bound(to_remove.dst());
-
-        assert(ri != r->second.end());
-
-        // cycle through the result, find the occurence of the link with the
-        // given ID, then remove
-        for (; ri != rend;) {
-            if (ri->second.id() == id) {
-                ri = r->second.erase(ri);
-            } else {
-                ++ri;
-            }
-        }
+        inheritanceChanged(to_remove.src());
 
         // fire the notification about inserted link
         LinkChangeMsg m(&to_remove);
@@ -686,9 +882,9 @@ void Relation::_removeLink(link_id_t id) {
 
 // --------------------------------------------------------------------------
 link_id_t Relation::getFreeLinkID(uint cidx) {
-    link_id_t id = LINK_MAKE_ID(mID, cidx, mMaxID[cidx] + 1);
-    allocateLinkID(id);
-    return id;
+    assert(cidx < 16);
+
+    return LINK_MAKE_ID(mID, cidx, mIDAllocators[cidx].allocate());
 }
 
 // --------------------------------------------------------------------------
@@ -697,11 +893,8 @@ void Relation::allocateLinkID(link_id_t id) {
 
     assert(cidx < 16);
 
-    link_id_t lidx = LINK_ID_INDEX(id);
-
-    if (mMaxID[cidx] < lidx) {
-        mMaxID[cidx] = lidx;
-    }
+    // already allocated if the id came from getFreeLinkID
+    mIDAllocators[cidx].reserve(LINK_ID_INDEX(id));
 }
 
 // --------------------------------------------------------------------------
@@ -710,36 +903,26 @@ void Relation::unallocateLinkID(link_id_t id) {
 
     assert(cidx < 16);
 
-    link_id_t lidx = LINK_ID_INDEX(id);
-
-    // I could make this customizable via some constructor parameter (having
-    // index array and bool, iterating)
-    if (mMaxID[cidx] == lidx) {
-        mMaxID[cidx]--;
-    }
-
-    // TODO: insert the link id into available for ID reuse...
+    mIDAllocators[cidx].release(LINK_ID_INDEX(id));
 }
 
 // --------------------------------------------------------------------------
 void Relation::_objectDestroyed(int id) {
     assert(id != 0); // has to be nonzero. Zero is a wildcard
 
-    ObjectLinkMap::const_iterator r = mSrcDstLinkMap.find(id);
+    // collect first, the removal will broadcast
+    std::vector<link_id_t> ids;
 
-    if (r != mSrcDstLinkMap.end()) {
-        // I could just remove it, but let's be fair and broadcast
-        // This will be very stormy.
-        LinkQueryResultPtr res(new MultiTargetLinkQueryResult(
-            r->second, r->second.begin(), r->second.end()));
+    LinkQueryResultPtr res = getAllLinks(id, 0);
 
-        // We have the source object. Now branch on the dest
-        while (!res->end()) {
-            // store by copy, so we can remove it safely in both cases
-            Link l = res->next();
-            _removeLink(l.id());
-            mInverse->_removeLink(l.id());
-        }
+    while (!res->end())
+        ids.push_back(res->next().id());
+
+    // I could just remove it, but let's be fair and broadcast
+    // This will be very stormy.
+    for (link_id_t lid : ids) {
+        _removeLink(lid);
+        mInverse->_removeLink(lid);
     }
 }
 } // namespace Opde
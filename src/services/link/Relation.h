@@ -25,11 +25,14 @@
 #define __RELATION_H
 
 #include <string>
+#include <unordered_map>
 
 #include "BitArray.h"
 #include "DataStorage.h"
 #include "FileGroup.h"
 #include "LinkCommon.h"
+#include "LinkIDAllocator.h"
+#include "LinkIndex.h"
 #include "MessageSource.h"
 #include "NonCopyable.h"
 
@@ -47,6 +50,8 @@ public:
      * @param db The database that the links are read from
      * @param objMask the mask that limits the loaded objects (invalid ones are
      * thrown away)
+     * @note The loaded links are announced by one LNK_RELATION_LOADED message
+     * per direction, not by LNK_ADDED
      */
     void load(const FileGroupPtr &db, const BitArray &objMask);
 
@@ -160,20 +165,61 @@ public:
      */
     Variant getLinkField(link_id_t id, const std::string &field);
 
+    /** Resolves the link data field name to a handle for the handle based
+     * setLinkField and getLinkField
+     * @return The handle, invalid if there is no such field or no link data */
+    FieldHandle getFieldHandle(const std::string &field);
+
+    /** Sets the link data field using a precompiled field handle
+     * @see setLinkField(link_id_t, const std::string &, const Variant &) */
+    bool setLinkField(link_id_t id, FieldHandle field, const Variant &value);
+
+    /** Gets the link data field value using a precompiled field handle
+     * @see getLinkField(link_id_t, const std::string &) */
+    Variant getLinkField(link_id_t id, FieldHandle field);
+
     // ----------------- Link query methods --------------------
     /** Gets all links that come from source to destination
      * @param src Source object ID
      * @param dst Destination object ID or 0 if any destination
-     * @return LinkQueryResultPtr filled with the query result */
+     * @return LinkQueryResultPtr filled with the query result, ordered by
+     * destination and link ID
+     * @note Links can be created and removed while walking the result. The
+     * created links are walked if they order after the last returned one */
     LinkQueryResultPtr getAllLinks(int src, int dst) const;
 
     /** Gets all links that come from given source, including links inherited
      * from source's ancestors (links from source or source's ancestors).
+     * The links of each source are collected once and cached, until the links
+     * or the inheritance of the source or it's ancestors change
      * @param src Source object ID
      * @param dst Optional destination object ID (or zero for any)
      * @return LinkQueryResultPtr filled with the query result */
     LinkQueryResultPtr getAllInherited(int src, int dst) const;
 
+    /** Notification that the inheritance of the object changed. Drops the
+     * cached inherited links of the object and it's descendants
+     * @see getAllInherited */
+    void inheritanceChanged(int objID);
+
+    /// Drops all the cached inherited links
+    void clearInheritedCache();
+
+    /// @return The count of getAllInherited calls answered from the cache
+    size_t getInheritedCacheHits() const { return mInheritedCacheHits; };
+
+    /// @return The count of getAllInherited calls that collected the links
+    size_t getInheritedCacheMisses() const { return mInheritedCacheMisses; };
+
+    /// @return The count of the objects with cached inherited links
+    size_t getInheritedCacheSize() const { return mInheritedCache.size(); };
+
+    /// Zeroes the inherited link cache hit and miss counters
+    void resetInheritedCacheStats() {
+        mInheritedCacheHits = 0;
+        mInheritedCacheMisses = 0;
+    };
+
     /** Gets single link ID that is coming from source to destination
      * @param src Source object ID, or 0 if any source
      * @param dst Destination object ID or 0 if any destination
@@ -229,6 +275,14 @@ protected:
      */
     void _addLink(const Link &newlnk);
 
+    /** Internal method for bulk link insertion, used when loading. Inserts
+     * the links to the map, rebuilds the query database in one pass, then
+     * notifies the listeners by a single LNK_RELATION_LOADED message
+     * @param links The links to be inserted
+     * @note The link data have to be assigned prior to calling this method
+     * @see _addLink */
+    void _addLinks(const std::vector<Link> &links);
+
     /** Internal method for link removal handling. Notifies the listeners,
      * refreshes query databases.
      * @param id The id of the link to be removed
@@ -241,24 +295,37 @@ protected:
      * @note concreteness 0 is usually used for abstract links (both src and dst
      * ID's end up < 0), concreteness 1 is used for links having at least one
      * end in positive object ID space (non abstract objects)
-     * @ret
+     * @return The allocated link id. Freed ids are reused
+     * @throw BasicException if the concreteness level has no free id left
      */
     link_id_t getFreeLinkID(uint cidx);
 
     /** Allocates the link ID, meaning it wont be given as free now.
      * @param id The link that was allocated
-     * @note This now only increments the maximal index for the concreteness of
-     * the link if it is bigger than that
+     * @note Does nothing if the id is allocated already
      */
     void allocateLinkID(link_id_t id);
 
     /** Unallocates the link ID, meaning it will be available again.
      * @param id The link that was allocated
-     * @note This now only decrements the maximal index of the concreteness the
-     * id has, if it was the maximal id
      */
     void unallocateLinkID(link_id_t id);
 
+    /** A link of the inherited link cache. Only the key is cached, the link
+     * is looked up when walked, so removed links are skipped. The src and dst
+     * guard against the link id being reused by another link meanwhile */
+    struct InheritedLink {
+        link_id_t id;
+        int src;
+        int dst;
+    };
+
+    typedef std::vector<InheritedLink> InheritedLinks;
+
+    /** Collects the links of the object and all it's ancestors
+     * @see getAllInherited */
+    void collectInherited(int objID, InheritedLinks &links) const;
+
     /** internal object destruction handler. @see objectDestroyed */
     void _objectDestroyed(int id);
 
@@ -266,20 +333,15 @@ protected:
     /// (LinkPtr)
     typedef std::map<link_id_t, Link> LinkMap;
 
-    /// Map of all links that have an object ID in either target or source
-    typedef std::multimap<int, Link> ObjectIDToLinks;
-
-    /// Map of all maps that share a certain object ID
-    typedef std::map<int, ObjectIDToLinks> ObjectLinkMap;
-
-    /// Map of links in source object ID, destination object id order
-    ObjectLinkMap mSrcDstLinkMap;
+    /// Index of the links in source object ID, destination object id order.
+    /// References the links stored in mLinkMap
+    LinkIndex mSrcDstIndex;
 
     /// ID of this relation (Flavor)
     int mID;
 
-    /// The maximal ID of the given concreteness level (only the index part)
-    link_id_t mMaxID[16];
+    /// Allocators of the link ID index part, one per concreteness level
+    LinkIDAllocator mIDAllocators[16];
 
     /// Name of this relation
     std::string mName;
@@ -311,6 +373,17 @@ protected:
 
     /// If true, data caching will be used
     bool mUseDataCache;
+
+    /// Source object ID to the links it has including the inherited ones
+    typedef std::unordered_map<int, shared_ptr<const InheritedLinks>>
+        InheritedCache;
+
+    /// Cache of the getAllInherited results
+    mutable InheritedCache mInheritedCache;
+
+    /// getAllInherited cache statistics
+    mutable size_t mInheritedCacheHits;
+    mutable size_t mInheritedCacheMisses;
 };
 
 /// Shared pointer on Relation
@@ -714,6 +714,15 @@ void MaterialService::onDBLoad(const FileGroupPtr &db, uint32_t curmask) {
         loadMaterials(db);
 }
 
+//------------------------------------------------------
+void MaterialService::getDBLoadChunks(uint32_t curmask,
+                                      std::vector<std::string> &chunks) {
+    if (curmask & DBM_MIS_DATA) {
+        chunks.push_back("TXLIST");
+        chunks.push_back("FLOW_TEX");
+    }
+}
+
 //------------------------------------------------------
 void MaterialService::onDBSave(const FileGroupPtr &db, uint32_t tgtmask) {
     LOG_INFO("MaterialService::onDBSave called.");
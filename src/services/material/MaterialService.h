@@ -160,6 +160,10 @@ protected:
      * @see DatabaseListener::onDBDrop */
     void onDBDrop(uint32_t dropmask);
 
+    /** Lists the chunks read by onDBLoad
+     * @see DatabaseListener::getDBLoadChunks */
+    void getDBLoadChunks(uint32_t curmask, std::vector<std::string> &chunks);
+
     /** Called by loadMaterials. Load the FLOW_TEX and initializes
      * \@templateXXXX according to IN and OUT texture numbers and names. Needs
      * material definitions
@@ -82,20 +82,20 @@ bool ObjectService::exists(int objID) { return mAllocatedObjects[objID]; }
 
 //------------------------------------------------------
 Vector3 ObjectService::position(int objID) {
-    Variant res;
+    const sPositionProp *pos = mPropPosition->view<sPositionProp>(objID);
 
-    if (mPropPosition->get(objID, "position", res)) {
-        return res.toVector();
+    if (pos) {
+        return pos->position;
     } else
         return Vector3::ZERO;
 }
 
 //------------------------------------------------------
 Quaternion ObjectService::orientation(int objID) {
-    Variant res;
+    const sPositionProp *pos = mPropPosition->view<sPositionProp>(objID);
 
-    if (mPropPosition->get(objID, "orientation", res)) {
-        return res.toQuaternion();
+    if (pos) {
+        return pos->facing;
     } else
         return Quaternion::IDENTITY;
 }
@@ -137,11 +137,11 @@ void ObjectService::teleport(int id, const Vector3 &pos, const Quaternion &ori,
     if (relative) {
         Vector3 _pos = position(id) + pos;
         Quaternion _ori = orientation(id) + ori;
-        mPropPosition->set(id, "position", _pos);
-        mPropPosition->set(id, "facing", _ori);
+        mPropPosition->set(id, mPositionField, _pos);
+        mPropPosition->set(id, mFacingField, _ori);
     } else {
-        mPropPosition->set(id, "position", pos);
-        mPropPosition->set(id, "facing", ori);
+        mPropPosition->set(id, mPositionField, pos);
+        mPropPosition->set(id, mFacingField, ori);
     }
 }
 
@@ -259,6 +259,9 @@ void ObjectService::createBuiltinResources() {
     mPropPosition = mPropertyService->createProperty("Position", "Position",
                                                      "never", mPositionStorage);
     mPropPosition->setChunkVersions(2, 65558);
+
+    mPositionField = mPropPosition->getFieldHandle("position");
+    mFacingField = mPropPosition->getFieldHandle("facing");
 }
 
 //------------------------------------------------------
@@ -307,6 +310,19 @@ void ObjectService::onDBLoad(const FileGroupPtr &db, uint32_t curmask) {
         _load(db, loadMask);
 }
 
+//------------------------------------------------------
+void ObjectService::getDBLoadChunks(uint32_t curmask,
+                                    std::vector<std::string> &chunks) {
+    // the same condition as in onDBLoad
+    if (!(curmask & (DBM_OBJTREE_CONCRETE | DBM_OBJTREE_GAMESYS)))
+        return;
+
+    // _load reads the object vector, then the properties and the links
+    chunks.push_back("ObjVec");
+    mPropertyService->getLoadChunks(chunks);
+    mLinkService->getLoadChunks(chunks);
+}
+
 //------------------------------------------------------
 void ObjectService::onDBSave(const FileGroupPtr &db, uint32_t tgtmask) {
     LOG_INFO("ObjectService::onDBSave called.");
@@ -177,6 +177,10 @@ protected:
      * @see DatabaseListener::onDBDrop */
     void onDBDrop(uint32_t dropmask);
 
+    /** Lists the chunks read by onDBLoad
+     * @see DatabaseListener::getDBLoadChunks */
+    void getDBLoadChunks(uint32_t curmask, std::vector<std::string> &chunks);
+
     /** load objects from a single database */
     void _load(const FileGroupPtr &db, uint clearMask);
 
@@ -225,6 +229,10 @@ protected:
     /// Position property (to set/get position/orientation of objects)
     Property *mPropPosition;
 
+    /// Precompiled handles of the position property fields
+    FieldHandle mPositionField;
+    FieldHandle mFacingField;
+
     /// Map's symbolic name to object ID
 
     /// Database service
@@ -25,11 +25,11 @@
 
 namespace Opde {
 
-PositionPropertyStorage::PositionPropertyStorage() {
-    field("position", &sPositionProp::position);
-    field("cell", &sPositionProp::cell);
-    field("facing", &sPositionProp::facing);
-};
+static const char *const sPositionFieldNames[] = {"position", "cell",
+                                                   "facing"};
+
+PositionPropertyStorage::PositionPropertyStorage()
+    : StructDataStorage(sPositionFieldNames){};
 
 PositionPropertyStorage::~PositionPropertyStorage(){};
 
@@ -34,8 +34,22 @@ struct sPositionProp {
     Quaternion facing;
 };
 
-/** Position property storage */
-class PositionPropertyStorage : public StructDataStorage<sPositionProp> {
+/// The stored fields of the position property
+typedef StructFieldList<sPositionProp,
+                        OPDE_STRUCT_FIELD(sPositionProp, position),
+                        OPDE_STRUCT_FIELD(sPositionProp, cell),
+                        OPDE_STRUCT_FIELD(sPositionProp, facing)>
+    PositionFields;
+
+// P$Position records are 22 bytes: 3 floats, cell uint, HPB as 3 int16
+static_assert(PositionFields::storedSize == 22,
+              "Position property record size mismatch");
+
+/** Position property storage. Nearly all concrete objects have a position, so
+ * the values are kept in a dense, id indexed array */
+class PositionPropertyStorage
+    : public StructDataStorage<sPositionProp, PositionFields,
+                               DenseDataMap<sPositionProp>> {
 public:
     PositionPropertyStorage();
     virtual ~PositionPropertyStorage();
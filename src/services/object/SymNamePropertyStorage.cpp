@@ -37,28 +37,15 @@ SymNamePropertyStorage::~SymNamePropertyStorage(){};
 // --------------------------------------------------------------------------
 bool SymNamePropertyStorage::destroy(int objID) {
     // Find the object name before destroying
-    Variant res;
+    DataMap::const_iterator it = mDataMap.find(objID);
 
-    if (getField(objID, "", res)) {
-        bool eraseok = StringDataStorage::destroy(objID);
-
-        assert(eraseok);
-
-        if (!eraseok)
-            return false;
-
-        // destroy our record as well
-        ReverseNameMap::iterator it = mReverseMap.find(res.toString());
-
-        if (it != mReverseMap.end()) {
-            mReverseMap.erase(it);
+    if (it == mDataMap.end())
+        return false;
 
-            // true, erase went ok on both sides
-            return true;
-        }
-    }
+    // destroy our record as well
+    mReverseMap.erase(it->second.id());
 
-    return false;
+    return StringDataStorage::destroy(objID);
 };
 
 // --------------------------------------------------------------------------
@@ -66,56 +53,50 @@ bool SymNamePropertyStorage::setField(int objID, const std::string &field,
                                       const Variant &value) {
     // if the parent's set field passes, update ourselves as well.
     // but first, look if we can proceed (name duplicity check)
+    InternedString name(value.toString());
 
-    ReverseNameMap::iterator it = mReverseMap.find(value.toString());
+    ReverseNameMap::iterator it = mReverseMap.find(name.id());
 
-    if (it != mReverseMap.end()) {
-        if (it->second != objID)
-            return false;
+    if (it != mReverseMap.end())
+        return it->second == objID;
 
-        return true;
-    }
+    DataMap::iterator sit = mDataMap.find(objID);
 
-    if (!has(objID))
+    if (sit == mDataMap.end())
         return false;
 
-    // get the previous name of the object, free that record
-    DataMap::const_iterator sit = mDataMap.find(objID);
-
-    assert(sit != mDataMap.end());
-
-    // name not in use yet, we can assign it
-    if (StringDataStorage::setField(objID, field, value)) {
-        ReverseNameMap::iterator rit = mReverseMap.find(sit->second);
-
-        mReverseMap.erase(rit);
-        mReverseMap.insert(std::make_pair(value.toString(), objID));
+    // name not in use yet, we can assign it. Free the previous name's record
+    mReverseMap.erase(sit->second.id());
+    mReverseMap.insert(std::make_pair(name.id(), objID));
 
-        assert(rit->second);
+    sit->second = name;
 
-        return true;
-    }
-
-    return false;
+    return true;
 }
 
 // --------------------------------------------------------------------------
-bool SymNamePropertyStorage::_create(int objID, const std::string &text) {
+bool SymNamePropertyStorage::_create(int objID, const InternedString &text) {
+    if (has(objID))
+        return false;
+
     std::pair<ReverseNameMap::iterator, bool> res =
-        mReverseMap.insert(std::make_pair(text, objID));
+        mReverseMap.insert(std::make_pair(text.id(), objID));
 
-    if (res.second) {
-        if (StringDataStorage::_create(objID, text)) {
-            return true;
-        }
-    }
+    if (!res.second)
+        return false;
 
-    return false;
+    return StringDataStorage::_create(objID, text);
 }
 
 // --------------------------------------------------------------------------
 int SymNamePropertyStorage::objectNamed(const std::string &name) {
-    ReverseNameMap::const_iterator it = mReverseMap.find(name);
+    StringPool::ID id = StringPool::getShared().find(name);
+
+    // a name not in the pool is not used by anyone
+    if (id == NULL && !name.empty())
+        return 0;
+
+    ReverseNameMap::const_iterator it = mReverseMap.find(id);
 
     if (it != mReverseMap.end()) {
         return it->second;
@@ -126,9 +107,12 @@ int SymNamePropertyStorage::objectNamed(const std::string &name) {
 
 // --------------------------------------------------------------------------
 bool SymNamePropertyStorage::nameUsed(const std::string &name) {
-    ReverseNameMap::iterator it = mReverseMap.find(name);
+    StringPool::ID id = StringPool::getShared().find(name);
+
+    if (id == NULL && !name.empty())
+        return false;
 
-    return (it != mReverseMap.end());
+    return mReverseMap.find(id) != mReverseMap.end();
 }
 
 // --------------------------------------------------------------------------
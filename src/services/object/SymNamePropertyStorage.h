@@ -26,13 +26,17 @@
 
 #include "SingleFieldDataStorage.h"
 
+#include <unordered_map>
+
 namespace Opde {
 
 /** A Bi-Directional unique string Symbolic name storage for symbolic names.
- * Overrides the StringPropertyStorage. */
+ * Overrides the StringPropertyStorage. The reverse map is keyed by the pooled
+ * name IDs, so the name lookups are constant time and no name is stored
+ * twice. */
 class SymNamePropertyStorage : public StringDataStorage {
 protected:
-    typedef std::map<std::string, int> ReverseNameMap;
+    typedef std::unordered_map<StringPool::ID, int> ReverseNameMap;
 
     ReverseNameMap mReverseMap;
 
@@ -42,10 +46,12 @@ public:
 
     virtual bool destroy(int objID);
 
+    using StringDataStorage::setField;
+
     virtual bool setField(int objID, const std::string &field,
                           const Variant &value);
 
-    virtual bool _create(int objID, const std::string &text);
+    virtual bool _create(int objID, const InternedString &text);
 
     virtual void clear();
 
@@ -89,6 +89,15 @@ void Property::shutdown() {
 
 // --------------------------------------------------------------------------
 void Property::load(const FileGroupPtr &db, const BitArray &objMask) {
+    std::vector<int> loaded;
+
+    loadData(db, objMask, loaded);
+    commitLoad(loaded);
+}
+
+// --------------------------------------------------------------------------
+void Property::loadData(const FileGroupPtr &db, const BitArray &objMask,
+                        std::vector<int> &loaded) {
     // Open the chunk specified by "P$" + mChunkName
     FilePtr fprop;
 
@@ -112,6 +121,12 @@ void Property::load(const FileGroupPtr &db, const BitArray &objMask) {
         return;
     }
 
+    // Fixed size storages decode the whole chunk in one pass
+    if (mPropertyStorage->getStoredSize() > 0) {
+        loadSpan(fprop, objMask, loaded);
+        return;
+    }
+
     // Can't calculate the count of the properties, as they can have any size
     // load. Each record has: OID, size (32 bit uint's)
     int id = 0xDEADBABE;
@@ -132,7 +147,60 @@ void Property::load(const FileGroupPtr &db, const BitArray &objMask) {
 
         // Use property storage to load the property
         if (mPropertyStorage->readFromFile(fprop, id, true)) {
-            _addProperty(id);
+            loaded.push_back(id);
+        } else {
+            LOG_ERROR("There was an error loading property %s for object %d. "
+                      "Property was not loaded",
+                      mName.c_str(), id);
+        }
+    }
+}
+
+// --------------------------------------------------------------------------
+void Property::loadSpan(const FilePtr &fprop, const BitArray &objMask,
+                        std::vector<int> &loaded) {
+    const uint32_t recSize = mPropertyStorage->getStoredSize();
+
+    FileSpan span = fprop->readSpan(fprop->size() - fprop->tell());
+
+    // Same records as in loadData: OID, size (32 bit uint's), data
+    while (!span.eof()) {
+        if (span.remaining() < 2 * sizeof(uint32_t)) {
+            LOG_ERROR("Property %s: truncated record header at %u, rest of the "
+                      "chunk ignored",
+                      mName.c_str(), (uint)span.tell());
+            return;
+        }
+
+        int32_t id;
+        uint32_t size;
+
+        span >> id >> size;
+
+        if (size > span.remaining()) {
+            LOG_ERROR("Property %s: object %d record of %u bytes exceeds the "
+                      "chunk, rest of the chunk ignored",
+                      mName.c_str(), id, size);
+            return;
+        }
+
+        // if the object is not in the mask, skip the property
+        if (!objMask[id]) {
+            LOG_DEBUG("Property::load: skipping object %d, not in bitmap", id);
+            span.skip(size);
+            continue;
+        }
+
+        if (size != recSize) {
+            LOG_ERROR("Property %s: object %d record has %u bytes, %u "
+                      "expected. Property was not loaded",
+                      mName.c_str(), id, size, recSize);
+            span.skip(size);
+            continue;
+        }
+
+        if (mPropertyStorage->readFromSpan(span, id)) {
+            loaded.push_back(id);
         } else {
             LOG_ERROR("There was an error loading property %s for object %d. "
                       "Property was not loaded",
@@ -141,6 +209,12 @@ void Property::load(const FileGroupPtr &db, const BitArray &objMask) {
     }
 }
 
+// --------------------------------------------------------------------------
+void Property::commitLoad(const std::vector<int> &loaded) {
+    for (int id : loaded)
+        _addProperty(id);
+}
+
 // --------------------------------------------------------------------------
 void Property::save(const FileGroupPtr &db, const BitArray &objMask) {
     // Open the chunk specified by "P$" + mChunkName
@@ -158,19 +232,15 @@ void Property::save(const FileGroupPtr &db, const BitArray &objMask) {
 
     // Can't calculate the count of the properties, as they can have any size
     // load. Each record has: OID, size (32 bit uint's)
-    IntIteratorPtr idit = mPropertyStorage->getAllStoredObjects();
-
-    while (!idit->end()) {
-        int id = idit->next();
-
+    mPropertyStorage->forEachStored([&](int id) {
         if (!objMask[id])
-            continue;
+            return;
 
         if (!mPropertyStorage->writeToFile(fprop, id, true))
             LOG_ERROR("There was an error writing property %s for object %d. "
                       "Property was not loaded",
                       mName.c_str(), id);
-    }
+    });
 }
 
 // --------------------------------------------------------------------------
@@ -246,6 +316,25 @@ bool Property::get(int id, const std::string &field, Variant &target) {
     return mPropertyStorage->getField(effID, field, target);
 }
 
+// --------------------------------------------------------------------------
+bool Property::set(int id, FieldHandle field, const Variant &value) {
+    if (mPropertyStorage->setField(id, field, value)) {
+        // the inheritor still works with the field names
+        const DataFields &fields = mPropertyStorage->getFieldDesc();
+        mInheritor->valueChanged(id, fields[field.index()].name, value);
+
+        return true;
+    }
+
+    return false;
+}
+
+// --------------------------------------------------------------------------
+bool Property::get(int id, FieldHandle field, Variant &target) {
+    int effID = _getEffectiveObject(id);
+    return mPropertyStorage->getField(effID, field, target);
+}
+
 // --------------------------------------------------------------------------
 void Property::_addProperty(int objID) {
     mInheritor->setImplements(objID, true);
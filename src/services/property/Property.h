@@ -33,6 +33,7 @@
 #include "OpdeException.h"
 #include "PropertyCommon.h"
 #include "inherit/InheritService.h"
+#include "format.h"
 #include "logger.h"
 
 namespace Opde {
@@ -84,6 +85,9 @@ public:
     /// Name getter. Returns the name of this property
     const std::string &getName() { return mName; };
 
+    /// Chunk name getter. The property is stored in the "P$" + chunk name
+    const std::string &getChunkName() { return mChunkName; };
+
     /** Determines whether an object with id obj_id stores or inherits property
      * of this type
      * @param obj_id The object id of the object
@@ -116,6 +120,22 @@ public:
      */
     void load(const FileGroupPtr &db, const BitArray &objMask);
 
+    /** First phase of load - decodes the property chunk into the property
+     * storage, without informing the inheritor. Only touches the storage, so
+     * it can run concurrently for different properties
+     * @param db The database to load from
+     * @param objMask The BitArray of objects to be loaded
+     * @param loaded Receives the ids of the objects that got the property
+     */
+    void loadData(const FileGroupPtr &db, const BitArray &objMask,
+                  std::vector<int> &loaded);
+
+    /** Second phase of load - informs the inheritor about the objects that got
+     * the property. Not thread safe
+     * @param loaded The ids filled by loadData
+     */
+    void commitLoad(const std::vector<int> &loaded);
+
     /** Saves properties to a file group
      * @param db The database to save to
      * @param objMask The BitArray of objects to be saved
@@ -171,6 +191,43 @@ public:
      */
     virtual bool get(int id, const std::string &field, Variant &target);
 
+    /** Resolves the field name to a handle for the handle based set and get
+     * @return The handle, invalid if there is no such field */
+    FieldHandle getFieldHandle(const std::string &field) {
+        return mPropertyStorage->getFieldHandle(field);
+    };
+
+    /** Direct data setter using a precompiled field handle
+     * @see set(int, const std::string &, const Variant &) */
+    virtual bool set(int id, FieldHandle field, const Variant &value);
+
+    /** Direct data getter using a precompiled field handle
+     * @see get(int, const std::string &, Variant &) */
+    virtual bool get(int id, FieldHandle field, Variant &target);
+
+    /** Typed direct data getter. Reads the stored value without any Variant
+     * conversion, respecting the inheritance (the value of the effective
+     * object is returned)
+     * @param id object id
+     * @return Pointer to the effective value, NULL if the object does not
+     * have the property. Valid until the property is next created, removed or
+     * cleared on any object
+     * @throw BasicException if T is not the type the property storage holds
+     */
+    template <typename T> const T *view(int id) const {
+        if (mPropertyStorage->getDataType() != typeid(T))
+            OPDE_EXCEPT(format("Property ", mName,
+                               " does not support typed access to ",
+                               typeid(T).name()));
+
+        int eoid = _getEffectiveObject(id);
+
+        if (eoid == 0)
+            return NULL;
+
+        return static_cast<const T *>(mPropertyStorage->getDataPtr(eoid));
+    }
+
     /** Notification that an object was destroyed. @see
      * PropertyService::objectDestroyed */
     void objectDestroyed(int id);
@@ -199,6 +256,13 @@ protected:
      */
     void _addProperty(int objID);
 
+    /** Bulk variant of the loadData record loop for storages with a fixed
+     * record size. Decodes all the records from one span of the chunk,
+     * validating the record sizes
+     * @see loadData */
+    void loadSpan(const FilePtr &fprop, const BitArray &objMask,
+                  std::vector<int> &loaded);
+
     /// The listener to the inheritance messages
     void onInheritChange(const InheritValueChangeMsg &msg);
 
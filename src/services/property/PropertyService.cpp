@@ -25,6 +25,7 @@
 #include "PropertyService.h"
 #include "OpdeServiceManager.h"
 #include "ServiceCommon.h"
+#include "Parallel.h"
 #include "format.h"
 #include "logger.h"
 
@@ -151,18 +152,70 @@ void PropertyService::unregisterProperty(Property *prop) {
 // --------------------------------------------------------------------------
 void PropertyService::load(const FileGroupPtr &db, const BitArray &objMask) {
     // We just give the db to all registered properties
+    std::vector<Property *> props;
+    props.reserve(mPropertyMap.size());
+
     PropertyMap::iterator it = mPropertyMap.begin();
 
-    for (; it != mPropertyMap.end(); ++it) {
+    for (; it != mPropertyMap.end(); ++it)
+        props.push_back(it->second);
+
+    // The chunks are decoded in parallel, each property into it's own
+    // storage. The inheritors are informed in a serial commit pass after
+    std::vector<std::vector<int>> loaded(props.size());
+    std::vector<std::string> errors(props.size());
+    std::vector<char> failed(props.size(), 0);
+
+    auto decode = [&](size_t idx) {
         try {
-            LOG_INFO("PropertyService: Loading property %s", it->first.c_str());
-            it->second->load(db, objMask);
+            LOG_INFO("PropertyService: Loading property %s",
+                     props[idx]->getName().c_str());
+            props[idx]->loadData(db, objMask, loaded[idx]);
         } catch (BasicException &e) {
+            errors[idx] = e.getDetails();
+            failed[idx] = 1;
+        }
+    };
+
+    // the chunk files share the source file position otherwise
+    if (db->isConcurrentReadSafe())
+        parallelFor(props.size(), decode);
+    else
+        for (size_t idx = 0; idx < props.size(); ++idx)
+            decode(idx);
+
+    // The inheritors propagate the effective objects once, for all the
+    // properties loaded, as the batch ends
+    InheritServicePtr inheritService = GET_SERVICE(InheritService);
+    InheritBatch batch(inheritService.get());
+
+    for (size_t idx = 0; idx < props.size(); ++idx) {
+        // the objects loaded before a failure keep their property
+        try {
+            props[idx]->commitLoad(loaded[idx]);
+        } catch (BasicException &e) {
+            // a failing listener must not stop the commit of the others
+            if (!failed[idx])
+                errors[idx] = e.getDetails();
+
+            failed[idx] = 1;
+        }
+
+        if (failed[idx])
             LOG_FATAL("PropertyService: Caught a fatal exception while loading "
                       "Property %s : %s",
-                      it->first.c_str(), e.getDetails().c_str());
-        }
+                      props[idx]->getName().c_str(), errors[idx].c_str());
     }
+
+    batch.end();
+}
+
+// --------------------------------------------------------------------------
+void PropertyService::getLoadChunks(std::vector<std::string> &chunks) {
+    PropertyMap::iterator it = mPropertyMap.begin();
+
+    for (; it != mPropertyMap.end(); ++it)
+        chunks.push_back("P$" + it->second->getChunkName());
 }
 
 // --------------------------------------------------------------------------
@@ -123,13 +123,19 @@ public:
      */
     void objectDestroyed(int id);
 
-    /** Load the properties from the database
+    /** Load the properties from the database. The property chunks are decoded
+     * in parallel if the database allows concurrent reads, the inheritors are
+     * informed afterwards, in the property name order
      * @param db The database file group to use
      * @param objMask The BitArray of objects to be loaded (other properties are
      * skipped)
      */
     void load(const FileGroupPtr &db, const BitArray &objMask);
 
+    /** Lists the chunks load reads, in the order they are read
+     * @param chunks The chunk names to append to */
+    void getLoadChunks(std::vector<std::string> &chunks);
+
     /** Saves the properties according to the saveMask
      * @param db The database file group to save to
      * @param objMask the BitArray of objects to be written */
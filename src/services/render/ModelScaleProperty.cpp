@@ -36,7 +36,7 @@ ModelScaleProperty::ModelScaleProperty(RenderService *rs,
                                        PropertyService *owner)
     : RenderedProperty(rs, owner, "ModelScale", "Scale", "always") {
 
-    mPropertyStorage = DataStoragePtr(new Vector3DataStorage(NULL));
+    mPropertyStorage = DataStoragePtr(new DenseVector3DataStorage(NULL));
 
     // TODO: Check the version
     setChunkVersions(2, 12);
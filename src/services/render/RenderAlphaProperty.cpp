@@ -36,7 +36,7 @@ RenderAlphaProperty::RenderAlphaProperty(RenderService *rs,
                                          PropertyService *owner)
     : RenderedProperty(rs, owner, "RenderAlpha", "RenderAlp", "always") {
 
-    mPropertyStorage = DataStoragePtr(new FloatDataStorage(NULL));
+    mPropertyStorage = DataStoragePtr(new DenseFloatDataStorage(NULL));
 
     // TODO: Check the version
     setChunkVersions(2, 65540);
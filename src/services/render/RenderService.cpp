@@ -56,6 +56,7 @@
 #include "logger.h"
 #include "loop/LoopService.h"
 #include "object/ObjectService.h"
+#include "object/PositionPropertyStorage.h"
 #include "property/PropertyService.h"
 
 #include "HasRefsProperty.h"
@@ -665,13 +666,14 @@ void RenderService::onPropPositionMsg(const PropertyChangeMsg &msg) {
             if (node == NULL)
                 return;
 
-            Variant pos;
-            mPropPosition->get(msg.objectID, "position", pos);
-            Variant ori;
-            mPropPosition->get(msg.objectID, "facing", ori);
+            const sPositionProp *pos =
+                mPropPosition->view<sPositionProp>(msg.objectID);
 
-            node->setPosition(pos.toVector());
-            node->setOrientation(ori.toQuaternion());
+            if (pos == NULL)
+                return;
+
+            node->setPosition(pos->position);
+            node->setOrientation(pos->facing);
 
         } catch (const BasicException &e) {
             LOG_ERROR(
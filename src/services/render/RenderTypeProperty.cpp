@@ -43,7 +43,7 @@ RenderTypeProperty::RenderTypeProperty(RenderService *rs,
     mEnum->insert("No Lightmap", RENDER_TYPE_NO_LIGHTMAP);
     mEnum->insert("Editor Only", RENDER_TYPE_EDITOR_ONLY);
 
-    mPropertyStorage = DataStoragePtr(new UIntDataStorage(mEnum.get()));
+    mPropertyStorage = DataStoragePtr(new DenseUIntDataStorage(mEnum.get()));
 
     // TODO: Check the version
     setChunkVersions(2, 4);
@@ -36,7 +36,7 @@ ZBiasProperty::ZBiasProperty(RenderService *rs, PropertyService *owner)
     : RenderedProperty(rs, owner, "RendererZBias", "Z-Bias", "always")
 {
 
-    mPropertyStorage = DataStoragePtr(new UIntDataStorage(NULL));
+    mPropertyStorage = DataStoragePtr(new DenseUIntDataStorage(NULL));
 
     setChunkVersions(2, 4);
 
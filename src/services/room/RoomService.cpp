@@ -188,6 +188,13 @@ void RoomService::onDBLoad(const FileGroupPtr &db, uint32_t curmask) {
     }
 }
 
+//------------------------------------------------------
+void RoomService::getDBLoadChunks(uint32_t curmask,
+                                  std::vector<std::string> &chunks) {
+    if (curmask & DBM_OBJTREE_CONCRETE)
+        chunks.push_back("ROOM_DB");
+}
+
 //------------------------------------------------------
 void RoomService::onDBSave(const FileGroupPtr &db, uint32_t tgtmask) {
     LOG_INFO("RoomService::onDBSave called.");
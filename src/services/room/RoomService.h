@@ -120,6 +120,20 @@ protected:
      * @see DatabaseListener::onDBDrop */
     void onDBDrop(uint32_t dropmask);
 
+    /** Lists the chunks read by onDBLoad
+     * @see DatabaseListener::getDBLoadChunks */
+    void getDBLoadChunks(uint32_t curmask, std::vector<std::string> &chunks);
+
+    /** The rooms only depend on the ROOM_DB chunk
+     * @see DatabaseListener::isDBLoadThreadSafe */
+    bool isDBLoadThreadSafe() { return true; };
+
+    /** No dependencies, the room database is self contained
+     * @see DatabaseListener::getDBLoadDependencies */
+    bool getDBLoadDependencies(std::vector<size_t> &priorities) {
+        return true;
+    };
+
 private:
     typedef std::unordered_map<int32_t, Room *> RoomsByID; // weak ptrs to rooms
     typedef std::vector<RoomsByID> ObjectIDSets;
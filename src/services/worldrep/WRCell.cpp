@@ -85,28 +85,41 @@ void WRCell::loadFromChunk(unsigned int _cell_num, FilePtr &chunk,
     // check the lightmap pixel size
     assert((lightSize >= 1) && (lightSize <= 2));
 
-    // The number in the comment is used by me to check if I deallocate what I
-    // allocated... load the header
-    *chunk >> mHeader;
+    // The cell is decoded from contiguous spans of the chunk - one for the
+    // header, one for the fixed size arrays and one for the variable sized
+    // tail.
+    FileSpan hspan = chunk->readSpan(WR_CELL_HEADER_SIZE);
+    hspan >> mHeader;
+
+    FileSpan span = chunk->readSpan(
+        mHeader.numVertices * WR_VERTEX_SIZE +
+        mHeader.numPolygons * WR_POLYGON_SIZE +
+        mHeader.numTextured * WR_POLYGON_TEXTURING_SIZE + sizeof(uint32_t));
 
     // 1. load the vertices
     mVertices.resize(mHeader.numVertices);
-    for (auto &vertex : mVertices) *chunk >> vertex;
+    for (auto &vertex : mVertices) span >> vertex;
 
     // 2. load the cell's polygon mapping
     mFaceMaps.resize(mHeader.numPolygons);
-    for (auto &face : mFaceMaps) *chunk >> face;
+    for (auto &face : mFaceMaps) span >> face;
 
     // 3. load the cell's texturing infos
     mFaceInfos.resize(mHeader.numTextured);
-    for (auto &faceInfo : mFaceInfos) *chunk >> faceInfo;
+    for (auto &faceInfo : mFaceInfos) span >> faceInfo;
 
     // polygon mapping struct.. len and data
 
     // load the polygon indices map (indices to the vertex data for this cell)
     // skip the total count of the indices
     uint32_t num_indices;
-    *chunk >> num_indices;
+    span >> num_indices;
+
+    file_size_t indexBytes = 0;
+    for (const auto &face : mFaceMaps) indexBytes += face.count;
+
+    FileSpan tail =
+        chunk->readSpan(indexBytes + mHeader.numPlanes * WR_PLANE_SIZE);
 
     // 4.
     mPolyIndices.resize(mHeader.numPolygons);
@@ -114,13 +127,13 @@ void WRCell::loadFromChunk(unsigned int _cell_num, FilePtr &chunk,
     // 5. for each polygon there is
     for (int x = 0; x < mHeader.numPolygons; x++) {
         mPolyIndices[x].resize(mFaceMaps[x].count);
-        chunk->read(mPolyIndices[x].data(), mFaceMaps[x].count);
+        tail.read(mPolyIndices[x].data(), mFaceMaps[x].count);
     }
 
     // 6. load the planes
     mPlanes.resize(mHeader.numPlanes);
     for (size_t i = 0; i < mHeader.numPlanes; ++i)
-        *chunk >> mPlanes[i];
+        tail >> mPlanes[i];
 
     // and load it's light info
     mLights.reset(new LightsForCell(chunk, mHeader.numAnimLights,
@@ -37,6 +37,13 @@
 
 namespace Opde {
 
+// On-disk sizes of the worldrep records (independent of Ogre::Real)
+#define WR_VERTEX_SIZE 12
+#define WR_PLANE_SIZE 16
+#define WR_CELL_HEADER_SIZE 31
+#define WR_POLYGON_SIZE 8
+#define WR_POLYGON_TEXTURING_SIZE 48
+
 struct WRHeader { // SIZE: 8
     uint32_t unk;
     uint32_t numCells;
@@ -104,6 +111,14 @@ struct WRCellHeader {    // SIZE: 31
             ch.center >> ch.radius;
         return st;
     }
+
+    friend FileSpan &operator>>(FileSpan &st, WRCellHeader &ch) {
+        st >> ch.numVertices >> ch.numPolygons >> ch.numTextured >>
+            ch.numPortals >> ch.numPlanes >> ch.mediaType >> ch.cellFlags >>
+            ch.nxn >> ch.polymapSize >> ch.numAnimLights >> ch.flowGroup >>
+            ch.center >> ch.radius;
+        return st;
+    }
 };
 
 struct WRPolygon {    // SIZE: 8
@@ -127,6 +142,12 @@ struct WRPolygon {    // SIZE: 8
             ch.unk1 >> ch.unk2;
         return st;
     }
+
+    friend FileSpan &operator>>(FileSpan &st, WRPolygon &ch) {
+        st >> ch.flags >> ch.count >> ch.plane >> ch.unk >> ch.tgtCell >>
+            ch.unk1 >> ch.unk2;
+        return st;
+    }
 };
 
 struct WRPolygonTexturing { // SIZE: 12+12+12+12 = 48
@@ -158,6 +179,12 @@ struct WRPolygonTexturing { // SIZE: 12+12+12+12 = 48
             ch.originVertex >> ch.unk >> ch.scale >> ch.center;
         return st;
     }
+
+    friend FileSpan &operator>>(FileSpan &st, WRPolygonTexturing &ch) {
+        st >> ch.axisU >> ch.axisV >> ch.u >> ch.v >> ch.txt >>
+            ch.originVertex >> ch.unk >> ch.scale >> ch.center;
+        return st;
+    }
 };
 
 /** Lightmap Information struct. */
@@ -224,6 +251,10 @@ struct WRBSPNode { // 20b - BSP node
 #define _BSP_FLAGS(a) (a.ndn_fl >> 24)
 #pragma pack(pop)
 
+/// BSP nodes are 32 bit fields only - bulk readable
+template <>
+struct FileBulkTraits<WRBSPNode> : public FileBulkUniform<WRBSPNode, 4> {};
+
 } // namespace Opde
 
 #endif
@@ -134,6 +134,17 @@ void WorldRepService::onDBLoad(const FileGroupPtr &db, uint32_t curmask) {
     loadFromChunk(wrChunk, lightSize);
 }
 
+//------------------------------------------------------
+void WorldRepService::getDBLoadChunks(uint32_t curmask,
+                                      std::vector<std::string> &chunks) {
+    if (!(curmask & DBM_MIS_DATA))
+        return;
+
+    // only one of these is present
+    chunks.push_back("WR");
+    chunks.push_back("WRRGB");
+}
+
 //------------------------------------------------------
 void WorldRepService::onDBSave(const FileGroupPtr &db, uint32_t tgtmask) {
     LOG_INFO("WorldRepService::onDBSave called.");
@@ -234,8 +245,7 @@ void WorldRepService::loadFromChunk(FilePtr &wrChunk, size_t lightSize) {
     // -- Load the extra planes
     wrChunk->read(&mExtraPlaneCount, sizeof(uint32_t));
 
-    mExtraPlanes.resize(mExtraPlaneCount);
-    for (auto &plane : mExtraPlanes) *wrChunk >> plane;
+    wrChunk->read_vector(mExtraPlanes, mExtraPlaneCount);
 
     // -------------------------------------------------------------------------
     // -- Load and process the BSP tree
@@ -245,13 +255,11 @@ void WorldRepService::loadFromChunk(FilePtr &wrChunk, size_t lightSize) {
     wrChunk->read(&BspRows, sizeof(uint32_t));
 
     // Load the BSP, and construct it
-    WRBSPNode *Bsp = new WRBSPNode[BspRows];
-    wrChunk->read(Bsp, BspRows * sizeof(WRBSPNode));
+    std::vector<WRBSPNode> Bsp;
+    wrChunk->read_vector(Bsp, BspRows);
 
     // Create the BspTree
-    createBSP(BspRows, Bsp);
-
-    delete[] Bsp;
+    createBSP(BspRows, Bsp.data());
 
     // assign the leaf nodes
     for (idx = 0; idx < header.numCells; idx++) {
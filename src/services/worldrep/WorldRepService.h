@@ -86,6 +86,10 @@ protected:
      * @see DatabaseListener::onDBDrop */
     void onDBDrop(uint32_t dropmask);
 
+    /** Lists the chunks read by onDBLoad
+     * @see DatabaseListener::getDBLoadChunks */
+    void getDBLoadChunks(uint32_t curmask, std::vector<std::string> &chunks);
+
     /** Internal method. Clears all the used data and scene */
     void clearData();
 